@@ -1,4 +1,5 @@
 #include <CL/cl.h>
+#include "ocl_svm.h"
 
 #ifdef _WIN32
 
@@ -74,6 +75,7 @@ typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clSetCommandQueueProperty)	(
 // Memory Object APIs
 
 typedef cl_mem				(CL_API_ENTRY CL_API_CALL * p_pfn_clCreateBuffer)				(cl_context, cl_mem_flags, size_t, void *, cl_int *);
+typedef cl_mem				(CL_API_ENTRY CL_API_CALL * p_pfn_clCreateSubBuffer)			(cl_mem, cl_mem_flags, cl_buffer_create_type, const void *, cl_int *);
 typedef cl_mem				(CL_API_ENTRY CL_API_CALL * p_pfn_clCreateImage2D)				(cl_context, cl_mem_flags, const cl_image_format *, size_t, size_t, size_t, void *, cl_int *);
 typedef cl_mem				(CL_API_ENTRY CL_API_CALL * p_pfn_clCreateImage3D)				(cl_context, cl_mem_flags, const cl_image_format *, size_t, size_t, size_t, size_t, size_t, void *, cl_int *);
 typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clRetainMemObject)			(cl_mem);
@@ -81,6 +83,7 @@ typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clReleaseMemObject)			(cl_me
 typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clGetSupportedImageFormats)	(cl_context, cl_mem_flags, cl_mem_object_type, cl_uint, cl_image_format *, cl_uint *);
 typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clGetMemObjectInfo)			(cl_mem, cl_mem_info, size_t, void *, size_t *);
 typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clGetImageInfo)				(cl_mem, cl_image_info, size_t, void *, size_t *);
+typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clSetMemObjectDestructorCallback)	(cl_mem, void (CL_CALLBACK *)(cl_mem, void *), void *);
 
 // Sampler APIs
 
@@ -158,6 +161,14 @@ typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clEnqueueBarrier)				(cl_com
 
 typedef void *				(CL_API_ENTRY CL_API_CALL * p_pfn_clGetExtensionFunctionAddress)(const char *);
 
+// Shared Virtual Memory APIs (OpenCL 2.0)
+
+typedef void *				(CL_API_ENTRY CL_API_CALL * p_pfn_clSVMAlloc)					(cl_context, cl_svm_mem_flags, size_t, cl_uint);
+typedef void				(CL_API_ENTRY CL_API_CALL * p_pfn_clSVMFree)					(cl_context, void *);
+typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clSetKernelArgSVMPointer)		(cl_kernel, cl_uint, const void *);
+typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clEnqueueSVMMap)				(cl_command_queue, cl_bool, cl_map_flags, void *, size_t, cl_uint, const cl_event *, cl_event *);
+typedef cl_int				(CL_API_ENTRY CL_API_CALL * p_pfn_clEnqueueSVMUnmap)			(cl_command_queue, void *, cl_uint, const cl_event *, cl_event *);
+
 p_pfn_clGetPlatformIDs				pfn_clGetPlatformIDs				= 0;
 p_pfn_clGetPlatformInfo				pfn_clGetPlatformInfo				= 0;
 p_pfn_clGetDeviceIDs				pfn_clGetDeviceIDs					= 0;
@@ -173,6 +184,7 @@ p_pfn_clReleaseCommandQueue			pfn_clReleaseCommandQueue			= 0;
 p_pfn_clGetCommandQueueInfo			pfn_clGetCommandQueueInfo			= 0;
 p_pfn_clSetCommandQueueProperty		pfn_clSetCommandQueueProperty		= 0;
 p_pfn_clCreateBuffer				pfn_clCreateBuffer					= 0;
+p_pfn_clCreateSubBuffer				pfn_clCreateSubBuffer				= 0;
 p_pfn_clCreateImage2D				pfn_clCreateImage2D					= 0;
 p_pfn_clCreateImage3D				pfn_clCreateImage3D					= 0;
 p_pfn_clRetainMemObject				pfn_clRetainMemObject				= 0;
@@ -180,6 +192,7 @@ p_pfn_clReleaseMemObject			pfn_clReleaseMemObject				= 0;
 p_pfn_clGetSupportedImageFormats	pfn_clGetSupportedImageFormats		= 0;
 p_pfn_clGetMemObjectInfo			pfn_clGetMemObjectInfo				= 0;
 p_pfn_clGetImageInfo				pfn_clGetImageInfo					= 0;
+p_pfn_clSetMemObjectDestructorCallback	pfn_clSetMemObjectDestructorCallback	= 0;
 p_pfn_clCreateSampler				pfn_clCreateSampler					= 0;
 p_pfn_clRetainSampler				pfn_clRetainSampler					= 0;
 p_pfn_clReleaseSampler				pfn_clReleaseSampler				= 0;
@@ -226,6 +239,11 @@ p_pfn_clEnqueueMarker				pfn_clEnqueueMarker					= 0;
 p_pfn_clEnqueueWaitForEvents		pfn_clEnqueueWaitForEvents			= 0;
 p_pfn_clEnqueueBarrier				pfn_clEnqueueBarrier				= 0;
 p_pfn_clGetExtensionFunctionAddress	pfn_clGetExtensionFunctionAddress	= 0;
+p_pfn_clSVMAlloc					pfn_clSVMAlloc						= 0;
+p_pfn_clSVMFree						pfn_clSVMFree						= 0;
+p_pfn_clSetKernelArgSVMPointer		pfn_clSetKernelArgSVMPointer		= 0;
+p_pfn_clEnqueueSVMMap				pfn_clEnqueueSVMMap					= 0;
+p_pfn_clEnqueueSVMUnmap				pfn_clEnqueueSVMUnmap				= 0;
 
 int ocl_init(void)
 {
@@ -249,6 +267,7 @@ int ocl_init(void)
 	pfn_clGetCommandQueueInfo			= (p_pfn_clGetCommandQueueInfo)			oclGetProcAddress(lib, "clGetCommandQueueInfo");
 	pfn_clSetCommandQueueProperty		= (p_pfn_clSetCommandQueueProperty)		oclGetProcAddress(lib, "clSetCommandQueueProperty");
 	pfn_clCreateBuffer					= (p_pfn_clCreateBuffer)				oclGetProcAddress(lib, "clCreateBuffer");
+	pfn_clCreateSubBuffer				= (p_pfn_clCreateSubBuffer)				oclGetProcAddress(lib, "clCreateSubBuffer");
 	pfn_clCreateImage2D					= (p_pfn_clCreateImage2D)				oclGetProcAddress(lib, "clCreateImage2D");
 	pfn_clCreateImage3D					= (p_pfn_clCreateImage3D)				oclGetProcAddress(lib, "clCreateImage3D");
 	pfn_clRetainMemObject				= (p_pfn_clRetainMemObject)				oclGetProcAddress(lib, "clRetainMemObject");
@@ -256,6 +275,7 @@ int ocl_init(void)
 	pfn_clGetSupportedImageFormats		= (p_pfn_clGetSupportedImageFormats)	oclGetProcAddress(lib, "clGetSupportedImageFormats");
 	pfn_clGetMemObjectInfo				= (p_pfn_clGetMemObjectInfo)			oclGetProcAddress(lib, "clGetMemObjectInfo");
 	pfn_clGetImageInfo					= (p_pfn_clGetImageInfo)				oclGetProcAddress(lib, "clGetImageInfo");
+	pfn_clSetMemObjectDestructorCallback	= (p_pfn_clSetMemObjectDestructorCallback)	oclGetProcAddress(lib, "clSetMemObjectDestructorCallback");
 	pfn_clCreateSampler					= (p_pfn_clCreateSampler)				oclGetProcAddress(lib, "clCreateSampler");
 	pfn_clRetainSampler					= (p_pfn_clRetainSampler)				oclGetProcAddress(lib, "clRetainSampler");
 	pfn_clReleaseSampler				= (p_pfn_clReleaseSampler)				oclGetProcAddress(lib, "clReleaseSampler");
@@ -302,6 +322,11 @@ int ocl_init(void)
 	pfn_clEnqueueWaitForEvents			= (p_pfn_clEnqueueWaitForEvents)		oclGetProcAddress(lib, "clEnqueueWaitForEvents");
 	pfn_clEnqueueBarrier				= (p_pfn_clEnqueueBarrier)				oclGetProcAddress(lib, "clEnqueueBarrier");
 	pfn_clGetExtensionFunctionAddress	= (p_pfn_clGetExtensionFunctionAddress)	oclGetProcAddress(lib, "clGetExtensionFunctionAddress");
+	pfn_clSVMAlloc						= (p_pfn_clSVMAlloc)					oclGetProcAddress(lib, "clSVMAlloc");
+	pfn_clSVMFree						= (p_pfn_clSVMFree)						oclGetProcAddress(lib, "clSVMFree");
+	pfn_clSetKernelArgSVMPointer		= (p_pfn_clSetKernelArgSVMPointer)		oclGetProcAddress(lib, "clSetKernelArgSVMPointer");
+	pfn_clEnqueueSVMMap					= (p_pfn_clEnqueueSVMMap)				oclGetProcAddress(lib, "clEnqueueSVMMap");
+	pfn_clEnqueueSVMUnmap				= (p_pfn_clEnqueueSVMUnmap)				oclGetProcAddress(lib, "clEnqueueSVMUnmap");
 
 	return 1;
 }
@@ -472,6 +497,18 @@ clCreateBuffer(cl_context   context,
 	return pfn_clCreateBuffer(context, flags, size, host_ptr, errcode_ret);
 }
 
+extern CL_API_ENTRY cl_mem CL_API_CALL
+clCreateSubBuffer(cl_mem                   buffer,
+                  cl_mem_flags             flags,
+                  cl_buffer_create_type    buffer_create_type,
+                  const void *             buffer_create_info,
+                  cl_int *                 errcode_ret) CL_API_SUFFIX__VERSION_1_1
+{
+	if (!pfn_clCreateSubBuffer) return 0;
+
+	return pfn_clCreateSubBuffer(buffer, flags, buffer_create_type, buffer_create_info, errcode_ret);
+}
+
 extern CL_API_ENTRY cl_mem CL_API_CALL
 clCreateImage2D(cl_context              context,
                 cl_mem_flags            flags,
@@ -557,6 +594,16 @@ clGetImageInfo(cl_mem           image,
 	return pfn_clGetImageInfo(image, param_name, param_value_size, param_value, param_value_size_ret);
 }
 
+extern CL_API_ENTRY cl_int CL_API_CALL
+clSetMemObjectDestructorCallback(cl_mem memobj,
+                                 void (CL_CALLBACK * pfn_notify)(cl_mem, void *),
+                                 void * user_data) CL_API_SUFFIX__VERSION_1_1
+{
+	if (!pfn_clSetMemObjectDestructorCallback) return CL_INVALID_OPERATION;
+
+	return pfn_clSetMemObjectDestructorCallback(memobj, pfn_notify, user_data);
+}
+
 
 // Sampler APIs
 extern CL_API_ENTRY cl_sampler CL_API_CALL
@@ -1140,3 +1187,61 @@ extern CL_API_ENTRY void * CL_API_CALL clGetExtensionFunctionAddress(const char
 
 	return pfn_clGetExtensionFunctionAddress(func_name);
 }
+
+// Shared Virtual Memory APIs (OpenCL 2.0)
+extern CL_API_ENTRY void * CL_API_CALL
+clSVMAlloc(cl_context       context,
+           cl_svm_mem_flags flags,
+           size_t           size,
+           cl_uint          alignment)
+{
+	if (!pfn_clSVMAlloc) return 0;
+
+	return pfn_clSVMAlloc(context, flags, size, alignment);
+}
+
+extern CL_API_ENTRY void CL_API_CALL
+clSVMFree(cl_context        context,
+          void *            svm_pointer)
+{
+	if (!pfn_clSVMFree) return;
+
+	pfn_clSVMFree(context, svm_pointer);
+}
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clSetKernelArgSVMPointer(cl_kernel    kernel,
+                         cl_uint      arg_index,
+                         const void * arg_value)
+{
+	if (!pfn_clSetKernelArgSVMPointer) return CL_INVALID_OPERATION;
+
+	return pfn_clSetKernelArgSVMPointer(kernel, arg_index, arg_value);
+}
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueSVMMap(cl_command_queue  command_queue,
+                cl_bool           blocking_map,
+                cl_map_flags      flags,
+                void *            svm_ptr,
+                size_t            size,
+                cl_uint           num_events_in_wait_list,
+                const cl_event *  event_wait_list,
+                cl_event *        event)
+{
+	if (!pfn_clEnqueueSVMMap) return CL_INVALID_OPERATION;
+
+	return pfn_clEnqueueSVMMap(command_queue, blocking_map, flags, svm_ptr, size, num_events_in_wait_list, event_wait_list, event);
+}
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueSVMUnmap(cl_command_queue  command_queue,
+                  void *            svm_ptr,
+                  cl_uint           num_events_in_wait_list,
+                  const cl_event *  event_wait_list,
+                  cl_event *        event)
+{
+	if (!pfn_clEnqueueSVMUnmap) return CL_INVALID_OPERATION;
+
+	return pfn_clEnqueueSVMUnmap(command_queue, svm_ptr, num_events_in_wait_list, event_wait_list, event);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+// OpenCL 2.0 shared virtual memory API, CL/cl.h is OpenCL 1.1.
+// Entry points are loaded by ocl_init() if the platform provides them, otherwise they fail.
+
+#include <CL/cl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef cl_bitfield									cl_svm_mem_flags;
+typedef cl_bitfield									cl_device_svm_capabilities;
+
+#ifndef CL_DEVICE_SVM_CAPABILITIES
+#define CL_DEVICE_SVM_CAPABILITIES					0x1053
+#endif
+
+#ifndef CL_DEVICE_SVM_COARSE_GRAIN_BUFFER
+#define CL_DEVICE_SVM_COARSE_GRAIN_BUFFER			(1 << 0)
+#define CL_DEVICE_SVM_FINE_GRAIN_BUFFER				(1 << 1)
+#define CL_DEVICE_SVM_FINE_GRAIN_SYSTEM				(1 << 2)
+#define CL_DEVICE_SVM_ATOMICS						(1 << 3)
+#endif
+
+#ifndef CL_MEM_SVM_FINE_GRAIN_BUFFER
+#define CL_MEM_SVM_FINE_GRAIN_BUFFER				(1 << 10)
+#define CL_MEM_SVM_ATOMICS							(1 << 11)
+#endif
+
+// returns 0 if SVM is not supported
+extern CL_API_ENTRY void * CL_API_CALL
+clSVMAlloc(cl_context       /* context */,
+           cl_svm_mem_flags /* flags */,
+           size_t           /* size */,
+           cl_uint          /* alignment */);
+
+extern CL_API_ENTRY void CL_API_CALL
+clSVMFree(cl_context        /* context */,
+          void *            /* svm_pointer */);
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clSetKernelArgSVMPointer(cl_kernel    /* kernel */,
+                         cl_uint      /* arg_index */,
+                         const void * /* arg_value */);
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueSVMMap(cl_command_queue  /* command_queue */,
+                cl_bool           /* blocking_map */,
+                cl_map_flags      /* flags */,
+                void *            /* svm_ptr */,
+                size_t            /* size */,
+                cl_uint           /* num_events_in_wait_list */,
+                const cl_event *  /* event_wait_list */,
+                cl_event *        /* event */);
+
+extern CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueSVMUnmap(cl_command_queue  /* command_queue */,
+                  void *            /* svm_ptr */,
+                  cl_uint           /* num_events_in_wait_list */,
+                  const cl_event *  /* event_wait_list */,
+                  cl_event *        /* event */);
+
+#ifdef __cplusplus
+}
+#endif
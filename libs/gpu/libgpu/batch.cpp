@@ -0,0 +1,145 @@
+#include "batch.h"
+#include "context.h"
+
+namespace gpu {
+
+Batch &Batch::execArray(ocl::KernelSource &kernel, const WorkSize &ws, const Arg *args, size_t nargs)
+{
+	Command command(Kernel, ws);
+	command.kernel = &kernel;
+	command.args.assign(args, args + nargs);
+	command.values.resize(nargs);
+
+	for (size_t i = 0; i < nargs; ++i) {
+		const Arg &arg = args[i];
+		// memory objects and SVM pointers are kept inside of the argument itself, local memory has no value
+		if (arg.is_null || !arg.value || arg.isMemObject() || arg.is_svm)
+			continue;
+
+		const unsigned char *value = (const unsigned char *) arg.value;
+		command.values[i].assign(value, value + arg.size);
+	}
+
+	commands_.push_back(command);
+	return *this;
+}
+
+Batch &Batch::write(const shared_device_buffer &dst, const void *data, size_t size, size_t offset)
+{
+	if (size == 0)
+		return *this;
+	if (offset + size > dst.size())
+		throw gpu_exception("Too many data for this device buffer: " + to_string(offset + size) + " > " + to_string(dst.size()));
+
+	Command command(Write, WorkSize(1, 1));
+	command.dst			= dst;
+	command.dst_offset	= offset;
+	command.size		= size;
+	command.written.assign((const unsigned char *) data, (const unsigned char *) data + size);
+
+	commands_.push_back(command);
+	return *this;
+}
+
+Batch &Batch::read(const shared_device_buffer &src, void *data, size_t size, size_t offset)
+{
+	if (size == 0)
+		return *this;
+	if (offset + size > src.size())
+		throw gpu_exception("Not enough data in this device buffer: " + to_string(offset + size) + " > " + to_string(src.size()));
+
+	Command command(Read, WorkSize(1, 1));
+	command.src			= src;
+	command.src_offset	= offset;
+	command.size		= size;
+	command.data		= data;
+
+	commands_.push_back(command);
+	return *this;
+}
+
+Batch &Batch::copy(const shared_device_buffer &src, const shared_device_buffer &dst, size_t size, size_t src_offset, size_t dst_offset)
+{
+	if (size == 0)
+		return *this;
+	if (src_offset + size > src.size() || dst_offset + size > dst.size())
+		throw gpu_exception("Copy out of device buffer bounds: " + to_string(size) + " bytes");
+
+	Command command(Copy, WorkSize(1, 1));
+	command.src			= src;
+	command.dst			= dst;
+	command.src_offset	= src_offset;
+	command.dst_offset	= dst_offset;
+	command.size		= size;
+
+	commands_.push_back(command);
+	return *this;
+}
+
+ocl::OpenCLEvent Batch::submit(const ocl::OpenCLStream &stream)
+{
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("Batch requires OpenCL context!");
+
+	ocl::sh_ptr_ocl_engine cl = context.cl();
+
+	// only the first command waits for the wait list, the others follow it in the same in-order queue
+	ocl::OpenCLStream queue(stream.queue());
+	ocl::OpenCLStream next = stream;
+
+	// the last command gets its own event, so that its execution error is reported
+	ocl::OpenCLEvent done;
+	for (size_t i = 0; i < commands_.size(); ++i) {
+		Command &command = commands_[i];
+		bool last = i + 1 == commands_.size();
+
+		switch (command.type) {
+		case Kernel:
+			for (size_t j = 0; j < command.args.size(); ++j) {
+				if (!command.values[j].empty())
+					command.args[j].value = command.values[j].data();
+			}
+			if (last) {
+				done = command.kernel->execAsyncArray(next, command.ws, command.args.data(), command.args.size());
+			} else {
+				command.kernel->enqueueArray(next, command.ws, command.args.data(), command.args.size());
+			}
+			break;
+		case Write:
+			if (last) {
+				done = cl->writeBufferAsync(command.dst.clmem(), command.dst.cloffset() + command.dst_offset, command.size, command.written.data(), next);
+			} else {
+				cl->enqueueWriteBuffer(command.dst.clmem(), command.dst.cloffset() + command.dst_offset, command.size, command.written.data(), next);
+			}
+			break;
+		case Read:
+			if (last) {
+				done = cl->readBufferAsync(command.src.clmem(), command.src.cloffset() + command.src_offset, command.size, command.data, next);
+			} else {
+				cl->enqueueReadBuffer(command.src.clmem(), command.src.cloffset() + command.src_offset, command.size, command.data, next);
+			}
+			break;
+		case Copy:
+			if (last) {
+				done = cl->copyBufferAsync(command.src.clmem(), command.dst.clmem(), command.src.cloffset() + command.src_offset,
+										   command.dst.cloffset() + command.dst_offset, command.size, next);
+			} else {
+				cl->enqueueCopyBuffer(command.src.clmem(), command.dst.clmem(), command.src.cloffset() + command.src_offset,
+									  command.dst.cloffset() + command.dst_offset, command.size, next);
+			}
+			break;
+		}
+
+		next = queue;
+	}
+
+	// an empty batch still completes after its wait list
+	if (commands_.empty())
+		done = cl->marker(next);
+
+	cl->flush(queue);
+	return done;
+}
+
+}
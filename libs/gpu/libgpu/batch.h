@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <libgpu/work_size.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/opencl/engine.h>
+
+namespace gpu {
+
+// Sequence of kernel launches and transfers submitted to an in-order OpenCL queue at once: commands are enqueued without events,
+// the queue is flushed once and only the last command gets an event, so many tiny kernels cost about one round trip.
+// Kernel arguments and written data are copied when a command is recorded, so a batch can be submitted several times.
+// Kernels, buffers and the batch itself must stay alive until the submitted commands are finished.
+class Batch {
+public:
+	typedef ocl::OpenCLKernelArg Arg;
+
+	template <typename... Args>
+	Batch &				exec(ocl::KernelSource &kernel, const WorkSize &ws, const Args &... args)
+	{
+		ocl::OpenCLKernelArgs<Args...> list(args...);
+		return execArray(kernel, ws, list.data(), list.size());
+	}
+
+	Batch &				execArray(ocl::KernelSource &kernel, const WorkSize &ws, const Arg *args, size_t nargs);
+	Batch &				write(const shared_device_buffer &dst, const void *data, size_t size, size_t offset = 0);
+	// data must stay valid until the batch is finished
+	Batch &				read(const shared_device_buffer &src, void *data, size_t size, size_t offset = 0);
+	Batch &				copy(const shared_device_buffer &src, const shared_device_buffer &dst, size_t size, size_t src_offset = 0, size_t dst_offset = 0);
+
+	// Enqueues all commands to the stream of the current context (the first one waits for its wait list) and flushes it once.
+	// The event is the one of the last command: it completes after all of them (the queue is in-order), but reports only
+	// the execution error of the last command. Errors of the others are not reported, unless profiling gives them events
+	// (then finish() throws them)
+	ocl::OpenCLEvent	submit(const ocl::OpenCLStream &stream = ocl::OpenCLStream());
+
+	void				clear()					{ commands_.clear();		}
+	size_t				size() const			{ return commands_.size();	}
+	bool				empty() const			{ return commands_.empty();	}
+
+protected:
+	enum CommandType {
+		Kernel,
+		Write,
+		Read,
+		Copy,
+	};
+
+	struct Command {
+		Command(CommandType type, const WorkSize &ws) : type(type), kernel(0), ws(ws), data(0), size(0), src_offset(0), dst_offset(0) {}
+
+		CommandType									type;
+		ocl::KernelSource *							kernel;
+		WorkSize									ws;
+		std::vector<Arg>							args;
+		std::vector<std::vector<unsigned char> >	values;		// copies of arguments passed by value, empty for the others
+
+		shared_device_buffer						src;
+		shared_device_buffer						dst;
+		void *										data;		// for Read
+		std::vector<unsigned char>					written;	// for Write
+		size_t										size;
+		size_t										src_offset;
+		size_t										dst_offset;
+	};
+
+	std::vector<Command>	commands_;
+};
+
+}
@@ -144,6 +144,30 @@ void Context::activate()
 	data_current_	= data_;
 }
 
+void Context::finish()
+{
+	switch (type()) {
+#ifdef CUDA_SUPPORT
+		case Context::TypeCUDA:
+			CUDA_SAFE_CALL(cudaStreamSynchronize(cudaStream()));
+			break;
+#endif
+		case Context::TypeOpenCL:
+			cl()->finish();
+			break;
+		default:
+			gpu::raiseException(__FILE__, __LINE__, "No GPU context!");
+	}
+}
+
+ocl::OpenCLStream Context::stream(const std::string &name)
+{
+	if (type() != TypeOpenCL)
+		gpu::raiseException(__FILE__, __LINE__, "Streams are supported only for OpenCL context!");
+
+	return cl()->stream(name);
+}
+
 Context::Data *Context::data() const
 {
 	if (!data_)
@@ -34,6 +34,12 @@ public:
 
 	void	activate();
 
+	// Waits for all enqueued commands of this context, reports errors of non-blocking commands
+	void	finish();
+
+	// Named OpenCL command queue (e.g. "transfer", "compute"), commands in different streams may overlap
+	ocl::OpenCLStream	stream(const std::string &name);
+
 	size_t 				getCoresEstimate();
 	size_t				getTotalMemory();
 	size_t				getFreeMemory();
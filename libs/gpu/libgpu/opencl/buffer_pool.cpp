@@ -0,0 +1,301 @@
+#include "buffer_pool.h"
+#include "engine.h"
+
+#include <limits>
+
+namespace ocl {
+
+BufferPool::BufferPool()
+{
+	max_cached_bytes_		= std::numeric_limits<size_t>::max();
+	base_address_alignment_	= 1;
+}
+
+BufferPool::~BufferPool()
+{
+	trim();
+
+	// buffers still in use are released by their owners
+}
+
+size_t BufferPool::sizeClass(size_t size)
+{
+	const size_t min_class = 256;
+	if (size <= min_class)
+		return min_class;
+
+	// 2^k, 1.25 * 2^k, 1.5 * 2^k, 1.75 * 2^k, so that rounding wastes less than 25%
+	size_t power = min_class;
+	while (power * 2 <= size && power * 2 > power)
+		power *= 2;
+
+	size_t step = power / 4;
+	size_t res = (size + step - 1) / step * step;
+	return res < size ? size : res;
+}
+
+cl_mem BufferPool::allocate(OpenCLEngine &engine, cl_mem_flags flags, size_t size)
+{
+	size_t capacity = sizeClass(size);
+	Key key(flags, capacity);
+
+	{
+		Lock lock(mutex_);
+
+		// the oldest released buffers are the most likely to be free already
+		std::map<Key, std::vector<Cached> >::iterator it = cached_.find(key);
+		if (it != cached_.end()) {
+			std::vector<Cached> &buffers = it->second;
+			for (size_t i = 0; i < buffers.size(); ++i) {
+				if (!isFree(buffers[i]))
+					continue;
+
+				cl_mem mem = buffers[i].mem;
+				buffers.erase(buffers.begin() + i);
+
+				++stats_.hits;
+				--stats_.buffers_cached;
+				stats_.bytes_cached -= capacity;
+				stats_.bytes_in_use += capacity;
+				return mem;
+			}
+		}
+
+		++stats_.misses;
+	}
+
+	cl_mem mem = 0;
+	try {
+		mem = engine.createBuffer(flags, capacity);
+	} catch (gpu::gpu_bad_alloc &) {
+		{
+			Lock lock(mutex_);
+			++stats_.trims;
+		}
+		trim();
+
+		mem = engine.createBuffer(flags, capacity);
+	}
+
+	Lock lock(mutex_);
+
+	Allocation allocation;
+	allocation.flags	= flags;
+	allocation.capacity	= capacity;
+	allocations_[mem]	= allocation;
+
+	stats_.bytes_in_use += capacity;
+	return mem;
+}
+
+void BufferPool::release(cl_mem mem)
+{
+	if (!mem)
+		return;
+
+	std::vector<cl_command_queue> queues;
+	bool cacheable = false;
+	{
+		Lock lock(mutex_);
+
+		std::map<cl_mem, Allocation>::const_iterator it = allocations_.find(mem);
+		cacheable = it != allocations_.end() && stats_.bytes_cached + it->second.capacity <= max_cached_bytes_;
+		queues = queues_;
+	}
+
+	// commands of other queues may still use the buffer, if a marker can't be enqueued the buffer is not cached
+	Cached cached;
+	cached.mem = mem;
+	if (cacheable && queues.size() > 1) {
+		try {
+			cached.markers = enqueueMarkers(queues);
+		} catch (const std::exception &) {
+			cacheable = false;
+		}
+	}
+
+	std::vector<cl_mem> released;
+	{
+		Lock lock(mutex_);
+
+		// sub-buffers are dropped in any case, otherwise they would pile up while the buffer is reused with new offsets
+		takeSubBuffers(mem, released);
+
+		std::map<cl_mem, Allocation>::const_iterator it = allocations_.find(mem);
+		if (it != allocations_.end()) {
+			const Allocation &allocation = it->second;
+			stats_.bytes_in_use -= allocation.capacity;
+
+			if (cacheable && stats_.bytes_cached + allocation.capacity <= max_cached_bytes_) {
+				cached_[Key(allocation.flags, allocation.capacity)].push_back(cached);
+				++stats_.buffers_cached;
+				stats_.bytes_cached += allocation.capacity;
+			} else {
+				allocations_.erase(mem);
+				released.push_back(mem);
+			}
+		} else {
+			released.push_back(mem);
+		}
+	}
+
+	releaseAll(released);
+}
+
+bool BufferPool::isFree(const Cached &cached)
+{
+	for (size_t i = 0; i < cached.markers.size(); ++i) {
+		if (!cached.markers[i].isComplete())
+			return false;
+	}
+	return true;
+}
+
+std::vector<OpenCLEvent> BufferPool::enqueueMarkers(const std::vector<cl_command_queue> &queues)
+{
+	std::vector<OpenCLEvent> markers;
+	for (size_t i = 0; i < queues.size(); ++i) {
+		cl_event ev = NULL;
+		OCL_SAFE_CALL(clEnqueueMarker(queues[i], &ev));
+		markers.push_back(OpenCLEvent(ev, "Buffer pool marker: "));
+		// otherwise the marker may never be submitted
+		OCL_SAFE_CALL(clFlush(queues[i]));
+	}
+	return markers;
+}
+
+void BufferPool::setQueues(const std::vector<cl_command_queue> &queues)
+{
+	Lock lock(mutex_);
+
+	// buffers released while there was a single queue get markers of the old queues before a new queue can use them
+	if (queues.size() > 1 && queues_.size() == 1 && stats_.buffers_cached > 0) {
+		std::vector<OpenCLEvent> markers;
+		try {
+			markers = enqueueMarkers(queues_);
+		} catch (const std::exception &) {
+			OCL_SAFE_CALL(clFinish(queues_[0]));
+		}
+
+		for (std::map<Key, std::vector<Cached> >::iterator it = cached_.begin(); it != cached_.end(); ++it) {
+			for (size_t i = 0; i < it->second.size(); ++i) {
+				if (it->second[i].markers.empty())
+					it->second[i].markers = markers;
+			}
+		}
+	}
+
+	queues_ = queues;
+}
+
+void BufferPool::takeSubBuffers(cl_mem mem, std::vector<cl_mem> &released)
+{
+	std::map<cl_mem, std::map<Region, cl_mem> >::iterator it = sub_buffers_.find(mem);
+	if (it == sub_buffers_.end())
+		return;
+
+	for (std::map<Region, cl_mem>::const_iterator sub = it->second.begin(); sub != it->second.end(); ++sub)
+		released.push_back(sub->second);
+	sub_buffers_.erase(it);
+}
+
+void BufferPool::releaseAll(const std::vector<cl_mem> &released)
+{
+	for (size_t i = 0; i < released.size(); ++i)
+		clReleaseMemObject(released[i]);
+
+	if (!released.empty())
+		OpenCLKernel::invalidateMemArgs();
+}
+
+cl_mem BufferPool::subBuffer(cl_mem mem, size_t offset, size_t size)
+{
+	Lock lock(mutex_);
+
+	if (offset % base_address_alignment_ != 0)
+		throw ocl_exception("Offset " + to_string(offset) + " is not aligned to " + to_string(base_address_alignment_) + " bytes, pass the view as ocl::OffsetView!");
+
+	std::map<Region, cl_mem> &sub_buffers = sub_buffers_[mem];
+	std::map<Region, cl_mem>::const_iterator it = sub_buffers.find(Region(offset, size));
+	if (it != sub_buffers.end())
+		return it->second;
+
+	cl_buffer_region region;
+	region.origin	= offset;
+	region.size		= size;
+
+	cl_int status = CL_SUCCESS;
+	cl_mem res = clCreateSubBuffer(mem, 0, CL_BUFFER_CREATE_TYPE_REGION, &region, &status);
+	OCL_SAFE_CALL(status);
+	if (!res)
+		throw ocl_exception("Sub-buffers are not supported (OpenCL 1.1 is required), pass the view as ocl::OffsetView!");
+
+	sub_buffers[Region(offset, size)] = res;
+	return res;
+}
+
+void BufferPool::setBaseAddressAlignment(size_t bytes)
+{
+	Lock lock(mutex_);
+	base_address_alignment_ = bytes ? bytes : 1;
+}
+
+void BufferPool::releaseCached(std::vector<cl_mem> &released, size_t max_bytes)
+{
+	// the biggest buffers first
+	for (std::map<Key, std::vector<Cached> >::reverse_iterator it = cached_.rbegin(); it != cached_.rend() && stats_.bytes_cached > max_bytes; ++it) {
+		std::vector<Cached> &buffers = it->second;
+		while (!buffers.empty() && stats_.bytes_cached > max_bytes) {
+			// the release is deferred by OpenCL until commands using the buffer are finished
+			cl_mem mem = buffers.back().mem;
+			buffers.pop_back();
+
+			--stats_.buffers_cached;
+			stats_.bytes_cached -= it->first.second;
+			allocations_.erase(mem);
+			takeSubBuffers(mem, released);
+			released.push_back(mem);
+		}
+	}
+}
+
+void BufferPool::trim(size_t max_bytes)
+{
+	std::vector<cl_mem> released;
+	{
+		Lock lock(mutex_);
+		releaseCached(released, max_bytes);
+	}
+
+	releaseAll(released);
+}
+
+void BufferPool::setMaxCachedBytes(size_t max_bytes)
+{
+	{
+		Lock lock(mutex_);
+		max_cached_bytes_ = max_bytes;
+	}
+	trim(max_bytes);
+}
+
+size_t BufferPool::maxCachedBytes() const
+{
+	Lock lock(mutex_);
+	return max_cached_bytes_;
+}
+
+size_t BufferPool::capacity(cl_mem mem) const
+{
+	Lock lock(mutex_);
+	std::map<cl_mem, Allocation>::const_iterator it = allocations_.find(mem);
+	return it != allocations_.end() ? it->second.capacity : 0;
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+	Lock lock(mutex_);
+	return stats_;
+}
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+#include <CL/cl.h>
+#include <libutils/thread_mutex.h>
+#include <libgpu/opencl/event.h>
+
+namespace ocl {
+
+class OpenCLEngine;
+
+// Caches released device buffers of an engine by size class and hands them out again instead of clCreateBuffer.
+// Allocations are rounded up to a size class (quarter steps between powers of two), so a cached buffer can be reused for
+// slightly different sizes. Owned by the engine and shared with all buffers allocated from it, so it outlives them.
+// While the engine has only its default in-order queue, a released buffer is handed out again right away: commands of
+// the next owner are ordered after the commands of the previous one. With several queues (streams, task graphs),
+// a marker is enqueued to every queue on release and the buffer is handed out only after all of them are complete.
+class BufferPool {
+public:
+	struct Stats {
+		Stats() : hits(0), misses(0), trims(0), buffers_cached(0), bytes_cached(0), bytes_in_use(0) { }
+
+		size_t	hits;
+		size_t	misses;
+		size_t	trims;				// caches dropped because of failed allocations
+		size_t	buffers_cached;
+		size_t	bytes_cached;
+		size_t	bytes_in_use;		// by capacity, i.e. including size class rounding
+	};
+
+	BufferPool();
+	~BufferPool();
+
+	// Returns a buffer of at least size bytes, on allocation failure drops all cached buffers and retries
+	cl_mem				allocate(OpenCLEngine &engine, cl_mem_flags flags, size_t size);
+	// Buffer is either cached or released, buffers not allocated by the pool are released
+	void				release(cl_mem mem);
+
+	// Releases cached buffers until no more than max_bytes are cached
+	void				trim(size_t max_bytes = 0);
+
+	// Released buffers are not cached over this limit (the default is a quarter of the device memory, set on engine init)
+	void				setMaxCachedBytes(size_t max_bytes);
+	size_t				maxCachedBytes() const;
+
+	// Cached sub-buffer [offset, offset + size) of the buffer, it is released when the buffer is released or returned to the cache.
+	// Throws if offset is not a multiple of the device CL_DEVICE_MEM_BASE_ADDR_ALIGN
+	cl_mem				subBuffer(cl_mem mem, size_t offset, size_t size);
+	void				setBaseAddressAlignment(size_t bytes);
+
+	// Queues of the engine which may still use released buffers, set by the engine whenever it creates or releases a queue
+	void				setQueues(const std::vector<cl_command_queue> &queues);
+
+	// 0 for buffers not allocated by the pool
+	size_t				capacity(cl_mem mem) const;
+	Stats				stats() const;
+
+	static size_t		sizeClass(size_t size);
+
+protected:
+	BufferPool(const BufferPool &);
+	BufferPool &operator= (const BufferPool &);
+
+	typedef std::pair<unsigned long long, size_t>	Key;	// flags (not cl_mem_flags, its alignment attribute is ignored in templates) and size class
+	typedef std::pair<size_t, size_t>		Region;
+
+	struct Allocation {
+		cl_mem_flags	flags;
+		size_t			capacity;
+	};
+
+	struct Cached {
+		cl_mem						mem;
+		std::vector<OpenCLEvent>	markers;	// the buffer is free when all of them are complete
+	};
+
+	void				releaseCached(std::vector<cl_mem> &released, size_t max_bytes);
+	// sub-buffers go first, they have to be released before their buffer
+	void				takeSubBuffers(cl_mem mem, std::vector<cl_mem> &released);
+	void				releaseAll(const std::vector<cl_mem> &released);
+	// Completes after all commands enqueued to the queues so far, throws if a marker can't be enqueued
+	static bool			isFree(const Cached &cached);
+	static std::vector<OpenCLEvent>	enqueueMarkers(const std::vector<cl_command_queue> &queues);
+
+	mutable Mutex						mutex_;
+	std::map<Key, std::vector<Cached> >	cached_;
+	std::vector<cl_command_queue>		queues_;
+	std::map<cl_mem, Allocation>		allocations_;
+	std::map<cl_mem, std::map<Region, cl_mem> >	sub_buffers_;
+	size_t								max_cached_bytes_;
+	size_t								base_address_alignment_;
+	Stats								stats_;
+};
+
+}
@@ -0,0 +1,110 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define TILE_SIZE 64
+#define TILE_K 16
+#define WORK_PER_ITEM 4
+#define TRANSPOSE_A 0
+#define TRANSPOSE_B 0
+#endif
+
+#line 12
+
+// T, TILE_SIZE, TILE_K, WORK_PER_ITEM and TRANSPOSE_A/B (0 or 1) are passed as defines.
+// A group computes a TILE_SIZE x TILE_SIZE tile of C, stepping along k by TILE_SIZE x TILE_K tiles of A and B staged
+// through local memory. Every work item keeps WORK_PER_ITEM x WORK_PER_ITEM results in registers: rows and columns
+// of a work item are RTS apart, so neighbouring work items read neighbouring local memory and write neighbouring C elements.
+
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#define RTS			(TILE_SIZE / WORK_PER_ITEM)
+#define GROUP_SIZE	(RTS * RTS)
+
+// All matrices are row-major. op(A) is m x k and op(B) is k x n, so A is stored as m x k (k x m if transposed)
+// and B as k x n (n x k if transposed). C = alpha * op(A) * op(B) + beta * C, C is not read if beta is zero
+__kernel __attribute__((reqd_work_group_size(RTS, RTS, 1)))
+void gemm(__global const T *a, __global const T *b, __global T *c,
+		  unsigned int m, unsigned int n, unsigned int k, T alpha, T beta)
+{
+	// a padding column puts elements of a tile column into different local memory banks
+	__local T tile_a[TILE_K][TILE_SIZE + 1];
+	__local T tile_b[TILE_K][TILE_SIZE + 1];
+
+	const unsigned int local_x = get_local_id(0);
+	const unsigned int local_y = get_local_id(1);
+	const unsigned int local_id = local_y * RTS + local_x;
+
+	const unsigned int row0 = get_group_id(1) * TILE_SIZE;
+	const unsigned int col0 = get_group_id(0) * TILE_SIZE;
+
+	T acc[WORK_PER_ITEM][WORK_PER_ITEM];
+	#pragma unroll
+	for (int i = 0; i < WORK_PER_ITEM; ++i) {
+		#pragma unroll
+		for (int j = 0; j < WORK_PER_ITEM; ++j) {
+			acc[i][j] = 0;
+		}
+	}
+
+	for (unsigned int k0 = 0; k0 < k; k0 += TILE_K) {
+		// the group reads along the contiguous dimension of the stored matrix, elements out of bounds are zeros
+		for (unsigned int idx = local_id; idx < TILE_SIZE * TILE_K; idx += GROUP_SIZE) {
+#if TRANSPOSE_A
+			const unsigned int row = idx % TILE_SIZE;
+			const unsigned int kk = idx / TILE_SIZE;
+			tile_a[kk][row] = (row0 + row < m && k0 + kk < k) ? a[(k0 + kk) * m + row0 + row] : 0;
+#else
+			const unsigned int kk = idx % TILE_K;
+			const unsigned int row = idx / TILE_K;
+			tile_a[kk][row] = (row0 + row < m && k0 + kk < k) ? a[(row0 + row) * k + k0 + kk] : 0;
+#endif
+
+#if TRANSPOSE_B
+			const unsigned int kb = idx % TILE_K;
+			const unsigned int col = idx / TILE_K;
+			tile_b[kb][col] = (col0 + col < n && k0 + kb < k) ? b[(col0 + col) * k + k0 + kb] : 0;
+#else
+			const unsigned int col = idx % TILE_SIZE;
+			const unsigned int kb = idx / TILE_SIZE;
+			tile_b[kb][col] = (col0 + col < n && k0 + kb < k) ? b[(k0 + kb) * n + col0 + col] : 0;
+#endif
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		#pragma unroll
+		for (int kk = 0; kk < TILE_K; ++kk) {
+			T b_reg[WORK_PER_ITEM];
+			#pragma unroll
+			for (int j = 0; j < WORK_PER_ITEM; ++j) {
+				b_reg[j] = tile_b[kk][local_x + j * RTS];
+			}
+
+			#pragma unroll
+			for (int i = 0; i < WORK_PER_ITEM; ++i) {
+				const T a_reg = tile_a[kk][local_y + i * RTS];
+				#pragma unroll
+				for (int j = 0; j < WORK_PER_ITEM; ++j) {
+					acc[i][j] += a_reg * b_reg[j];
+				}
+			}
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	#pragma unroll
+	for (int i = 0; i < WORK_PER_ITEM; ++i) {
+		const unsigned int row = row0 + local_y + i * RTS;
+		#pragma unroll
+		for (int j = 0; j < WORK_PER_ITEM; ++j) {
+			const unsigned int col = col0 + local_x + j * RTS;
+			if (row < m && col < n) {
+				const unsigned int idx = row * n + col;
+				c[idx] = beta == 0 ? alpha * acc[i][j] : alpha * acc[i][j] + beta * c[idx];
+			}
+		}
+	}
+}
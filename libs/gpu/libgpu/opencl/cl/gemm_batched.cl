@@ -0,0 +1,77 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define M 4
+#define N 4
+#define K 4
+#define GROUP_SIZE 256
+#define MATRICES_PER_STEP 64
+#define USE_LOCAL 1
+#endif
+
+#line 13
+
+// T, matrix sizes M, N, K (op(A) is M x K, B is K x N), GROUP_SIZE, MATRICES_PER_STEP and USE_LOCAL (0 or 1) are passed as defines,
+// so the loops over matrix elements have constant bounds and the dot products are unrolled.
+// A work group walks over the batch MATRICES_PER_STEP products at a time: it copies their A and B into local memory
+// with coalesced reads (unless they don't fit, then they are read from global memory through the cache)
+// and every work item computes elements of C, consecutive work items compute consecutive elements.
+
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+// C[i] = alpha * A[i] * B[i] + beta * C[i], matrix i starts at i * stride of its array, all of them are row-major.
+// C is not read if beta is zero
+__kernel __attribute__((reqd_work_group_size(GROUP_SIZE, 1, 1)))
+void gemm_batched(__global const T *a, __global const T *b, __global T *c,
+				  unsigned int stride_a, unsigned int stride_b, unsigned int stride_c, unsigned int batch, T alpha, T beta)
+{
+	const unsigned int local_id = get_local_id(0);
+
+#if USE_LOCAL
+	__local T local_a[MATRICES_PER_STEP * M * K];
+	__local T local_b[MATRICES_PER_STEP * K * N];
+#endif
+
+	for (unsigned int first = get_group_id(0) * MATRICES_PER_STEP; first < batch; first += get_num_groups(0) * MATRICES_PER_STEP) {
+		const unsigned int count = min((unsigned int) MATRICES_PER_STEP, batch - first);
+
+#if USE_LOCAL
+		for (unsigned int idx = local_id; idx < count * M * K; idx += GROUP_SIZE) {
+			local_a[idx] = a[(ulong) (first + idx / (M * K)) * stride_a + idx % (M * K)];
+		}
+		for (unsigned int idx = local_id; idx < count * K * N; idx += GROUP_SIZE) {
+			local_b[idx] = b[(ulong) (first + idx / (K * N)) * stride_b + idx % (K * N)];
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+#endif
+
+		for (unsigned int idx = local_id; idx < count * M * N; idx += GROUP_SIZE) {
+			const unsigned int matrix = idx / (M * N);
+			const unsigned int row = idx % (M * N) / N;
+			const unsigned int col = idx % N;
+
+#if USE_LOCAL
+			__local const T *row_a = local_a + matrix * M * K + row * K;
+			__local const T *col_b = local_b + matrix * K * N + col;
+#else
+			__global const T *row_a = a + (ulong) (first + matrix) * stride_a + row * K;
+			__global const T *col_b = b + (ulong) (first + matrix) * stride_b + col;
+#endif
+
+			T sum = 0;
+			#pragma unroll
+			for (int l = 0; l < K; ++l) {
+				sum += row_a[l] * col_b[l * N];
+			}
+
+			__global T *res = c + (ulong) (first + matrix) * stride_c + row * N + col;
+			*res = beta == 0 ? alpha * sum : alpha * sum + beta * *res;
+		}
+
+#if USE_LOCAL
+		barrier(CLK_LOCAL_MEM_FENCE);
+#endif
+	}
+}
@@ -0,0 +1,137 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define GROUP_SIZE 256
+#endif
+
+#line 8
+
+// T and GROUP_SIZE (a power of two) are passed as defines.
+// A range is described by (sum, max_prefix, index): its total sum, the maximum sum of its non-empty prefixes and the index
+// of the last element of the first such prefix. Ranges are combined in order, so the tree reduction keeps neighbours together.
+
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#define ITEMS_PER_WORK_ITEM	4
+#define TILE_SIZE			(GROUP_SIZE * ITEMS_PER_WORK_ITEM)
+#define EMPTY_INDEX			0xFFFFFFFFu
+
+// a = a followed by b
+void combine(T *sum, T *max_prefix, unsigned int *index, T b_sum, T b_max_prefix, unsigned int b_index)
+{
+	if (b_index == EMPTY_INDEX)
+		return;
+
+	if (*index == EMPTY_INDEX || *sum + b_max_prefix > *max_prefix) {
+		*max_prefix	= *sum + b_max_prefix;
+		*index		= b_index;
+	}
+	*sum += b_sum;
+}
+
+// The result is in the first elements of the arrays
+void reduceGroup(__local T *sums, __local T *max_prefixes, __local unsigned int *indices, unsigned int local_id)
+{
+	#pragma unroll
+	for (unsigned int s = 1; s < GROUP_SIZE; s *= 2) {
+		if (local_id % (2 * s) == 0) {
+			T sum = sums[local_id];
+			T max_prefix = max_prefixes[local_id];
+			unsigned int index = indices[local_id];
+			combine(&sum, &max_prefix, &index, sums[local_id + s], max_prefixes[local_id + s], indices[local_id + s]);
+			sums[local_id] = sum;
+			max_prefixes[local_id] = max_prefix;
+			indices[local_id] = index;
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+}
+
+// Every group processes tiles_per_group consecutive tiles and writes the description of its range
+__kernel __attribute__((reqd_work_group_size(GROUP_SIZE, 1, 1)))
+void max_prefix_sum(__global const T *as, unsigned int n, unsigned int tiles_per_group,
+					__global T *sums, __global T *max_prefixes, __global unsigned int *indices)
+{
+	const unsigned int local_id = get_local_id(0);
+
+	__local T tile[TILE_SIZE];
+	__local T local_sums[GROUP_SIZE];
+	__local T local_max_prefixes[GROUP_SIZE];
+	__local unsigned int local_indices[GROUP_SIZE];
+
+	T carry_sum = 0;
+	T carry_max_prefix = 0;
+	unsigned int carry_index = EMPTY_INDEX;
+
+	for (unsigned int t = 0; t < tiles_per_group; ++t) {
+		const unsigned int base = (get_group_id(0) * tiles_per_group + t) * TILE_SIZE;
+		if (base >= n)
+			break;
+
+		#pragma unroll
+		for (unsigned int k = 0; k < ITEMS_PER_WORK_ITEM; ++k) {
+			const unsigned int i = base + k * GROUP_SIZE + local_id;
+			tile[k * GROUP_SIZE + local_id] = i < n ? as[i] : 0;
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		// consecutive items of the work item
+		T sum = 0;
+		T max_prefix = 0;
+		unsigned int index = EMPTY_INDEX;
+		#pragma unroll
+		for (unsigned int k = 0; k < ITEMS_PER_WORK_ITEM; ++k) {
+			const unsigned int i = base + local_id * ITEMS_PER_WORK_ITEM + k;
+			if (i < n) {
+				sum += tile[local_id * ITEMS_PER_WORK_ITEM + k];
+				if (index == EMPTY_INDEX || sum > max_prefix) {
+					max_prefix	= sum;
+					index		= i;
+				}
+			}
+		}
+		local_sums[local_id] = sum;
+		local_max_prefixes[local_id] = max_prefix;
+		local_indices[local_id] = index;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		reduceGroup(local_sums, local_max_prefixes, local_indices, local_id);
+
+		if (local_id == 0)
+			combine(&carry_sum, &carry_max_prefix, &carry_index, local_sums[0], local_max_prefixes[0], local_indices[0]);
+		// the tile and the arrays are overwritten by the next tile
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (local_id == 0) {
+		sums[get_group_id(0)]			= carry_sum;
+		max_prefixes[get_group_id(0)]	= carry_max_prefix;
+		indices[get_group_id(0)]		= carry_index;
+	}
+}
+
+// Combines n <= GROUP_SIZE ranges in place into the first one, launched as a single group
+__kernel __attribute__((reqd_work_group_size(GROUP_SIZE, 1, 1)))
+void max_prefix_sum_merge(__global T *sums, __global T *max_prefixes, __global unsigned int *indices, unsigned int n)
+{
+	const unsigned int local_id = get_local_id(0);
+
+	__local T local_sums[GROUP_SIZE];
+	__local T local_max_prefixes[GROUP_SIZE];
+	__local unsigned int local_indices[GROUP_SIZE];
+
+	local_sums[local_id]			= local_id < n ? sums[local_id]			: 0;
+	local_max_prefixes[local_id]	= local_id < n ? max_prefixes[local_id]	: 0;
+	local_indices[local_id]			= local_id < n ? indices[local_id]		: EMPTY_INDEX;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	reduceGroup(local_sums, local_max_prefixes, local_indices, local_id);
+
+	if (local_id == 0) {
+		sums[0]			= local_sums[0];
+		max_prefixes[0]	= local_max_prefixes[0];
+		indices[0]		= local_indices[0];
+	}
+}
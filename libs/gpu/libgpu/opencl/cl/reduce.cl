@@ -0,0 +1,41 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define OP(a, b) ((a) + (b))
+#define GROUP_SIZE 256
+#endif
+
+#line 9
+
+// T and GROUP_SIZE (a power of two) are passed as defines, OP(a, b) is defined by the preamble
+
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+// Every work group reduces a grid-stride range of as into res[group id], so a grid of one group gives the final result.
+// Ranges are accumulated in registers, then the group is reduced in local memory by a tree. Its bounds are compile-time
+// constants, so it is fully unrolled. Every level ends with a barrier, lockstep execution of a warp is not assumed.
+__kernel __attribute__((reqd_work_group_size(GROUP_SIZE, 1, 1)))
+void reduce(__global const T *as, __global T *res, unsigned int n, T identity)
+{
+	const unsigned int local_id = get_local_id(0);
+
+	T acc = identity;
+	for (unsigned int i = get_global_id(0); i < n; i += get_global_size(0))
+		acc = OP(acc, as[i]);
+
+	__local T buf[GROUP_SIZE];
+	buf[local_id] = acc;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	#pragma unroll
+	for (unsigned int s = GROUP_SIZE / 2; s > 0; s /= 2) {
+		if (local_id < s)
+			buf[local_id] = OP(buf[local_id], buf[local_id + s]);
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (local_id == 0)
+		res[get_group_id(0)] = buf[0];
+}
@@ -0,0 +1,101 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define GROUP_SIZE 256
+#endif
+
+#line 8
+
+// T and GROUP_SIZE (a power of two) are passed as defines.
+// Hierarchical scan: block sums are computed by scan_block_sums, scanned recursively (exclusively) and added by scan_blocks.
+
+#define ITEMS_PER_WORK_ITEM	4
+#define BLOCK_SIZE			(GROUP_SIZE * ITEMS_PER_WORK_ITEM)
+
+__kernel __attribute__((reqd_work_group_size(GROUP_SIZE, 1, 1)))
+void scan_block_sums(__global const T *as, __global T *sums, unsigned int n)
+{
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int base = get_group_id(0) * BLOCK_SIZE;
+
+	T acc = 0;
+	#pragma unroll
+	for (unsigned int k = 0; k < ITEMS_PER_WORK_ITEM; ++k) {
+		const unsigned int i = base + k * GROUP_SIZE + local_id;
+		if (i < n)
+			acc += as[i];
+	}
+
+	__local T buf[GROUP_SIZE];
+	buf[local_id] = acc;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	#pragma unroll
+	for (unsigned int s = GROUP_SIZE / 2; s > 0; s /= 2) {
+		if (local_id < s)
+			buf[local_id] += buf[local_id + s];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (local_id == 0)
+		sums[get_group_id(0)] = buf[0];
+}
+
+// Scans every block in local memory: each work item scans its consecutive items sequentially, then sums of work items are
+// scanned by the group. offsets are the exclusive prefix sums of blocks (ignored if has_offsets is 0).
+// as and res may be the same buffer: a block is read completely before it is written
+__kernel __attribute__((reqd_work_group_size(GROUP_SIZE, 1, 1)))
+void scan_blocks(__global const T *as, __global T *res, __global const T *offsets, unsigned int n,
+				 unsigned int exclusive, unsigned int has_offsets)
+{
+	const unsigned int local_id = get_local_id(0);
+	const unsigned int base = get_group_id(0) * BLOCK_SIZE;
+
+	__local T block[BLOCK_SIZE];
+	__local T sums[GROUP_SIZE];
+
+	// coalesced loads, out of range items are zeros
+	#pragma unroll
+	for (unsigned int k = 0; k < ITEMS_PER_WORK_ITEM; ++k) {
+		const unsigned int i = base + k * GROUP_SIZE + local_id;
+		block[k * GROUP_SIZE + local_id] = i < n ? as[i] : 0;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	T items[ITEMS_PER_WORK_ITEM];
+	T sum = 0;
+	#pragma unroll
+	for (unsigned int k = 0; k < ITEMS_PER_WORK_ITEM; ++k) {
+		sum += block[local_id * ITEMS_PER_WORK_ITEM + k];
+		items[k] = sum;
+	}
+	sums[local_id] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// inclusive scan of work item sums
+	#pragma unroll
+	for (unsigned int offset = 1; offset < GROUP_SIZE; offset *= 2) {
+		T value = local_id >= offset ? sums[local_id - offset] : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		sums[local_id] += value;
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	T prefix = local_id > 0 ? sums[local_id - 1] : 0;
+	if (has_offsets)
+		prefix += offsets[get_group_id(0)];
+
+	#pragma unroll
+	for (unsigned int k = 0; k < ITEMS_PER_WORK_ITEM; ++k) {
+		T value = exclusive ? (k > 0 ? items[k - 1] : 0) : items[k];
+		block[local_id * ITEMS_PER_WORK_ITEM + k] = prefix + value;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	#pragma unroll
+	for (unsigned int k = 0; k < ITEMS_PER_WORK_ITEM; ++k) {
+		const unsigned int i = base + k * GROUP_SIZE + local_id;
+		if (i < n)
+			res[i] = block[k * GROUP_SIZE + local_id];
+	}
+}
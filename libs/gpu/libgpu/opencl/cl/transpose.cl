@@ -0,0 +1,53 @@
+#ifdef __CLION_IDE__
+#include "clion_defines.cl"
+#define T float
+#define TILE_SIZE 32
+#define TILE_ROWS 8
+#endif
+
+#line 9
+
+// T, TILE_SIZE and TILE_ROWS (a divisor of TILE_SIZE) are passed as defines.
+// A group transposes a TILE_SIZE x TILE_SIZE tile through local memory, every work item moves TILE_SIZE / TILE_ROWS elements,
+// so both reads and writes of global memory are coalesced. The tile has a padding column: its columns are read
+// with stride TILE_SIZE + 1, so they fall into different local memory banks.
+
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+// as is height x width, res is width x height, both row-major. Matrices of a batch follow each other,
+// groups along y cover tiles_y tiles of each matrix in turn
+__kernel __attribute__((reqd_work_group_size(TILE_SIZE, TILE_ROWS, 1)))
+void transpose(__global const T *as, __global T *res, unsigned int width, unsigned int height, unsigned int tiles_y)
+{
+	__local T tile[TILE_SIZE][TILE_SIZE + 1];
+
+	const unsigned int local_x = get_local_id(0);
+	const unsigned int local_y = get_local_id(1);
+
+	const unsigned int matrix = get_group_id(1) / tiles_y;
+	const unsigned int tile_x = get_group_id(0) * TILE_SIZE;
+	const unsigned int tile_y = (get_group_id(1) % tiles_y) * TILE_SIZE;
+
+	as	+= (size_t) matrix * width * height;
+	res	+= (size_t) matrix * width * height;
+
+	#pragma unroll
+	for (unsigned int r = local_y; r < TILE_SIZE; r += TILE_ROWS) {
+		const unsigned int x = tile_x + local_x;
+		const unsigned int y = tile_y + r;
+		if (x < width && y < height)
+			tile[r][local_x] = as[y * width + x];
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	#pragma unroll
+	for (unsigned int r = local_y; r < TILE_SIZE; r += TILE_ROWS) {
+		const unsigned int x = tile_y + local_x;
+		const unsigned int y = tile_x + r;
+		if (x < height && y < width)
+			res[y * height + x] = tile[local_x][r];
+	}
+}
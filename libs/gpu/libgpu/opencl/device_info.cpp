@@ -1,5 +1,6 @@
 #include "device_info.h"
 #include "utils.h"
+#include <libclew/ocl_svm.h>
 #include <iostream>
 #include <vector>
 
@@ -15,7 +16,11 @@ DeviceInfo::DeviceInfo()
 	max_work_item_sizes[1]		= 0;
 	max_work_item_sizes[2]		= 0;
 	global_mem_size				= 0;
+	local_mem_size				= 0;
 	device_address_bits			= 0;
+	mem_base_addr_align			= 0;
+	host_unified_memory			= false;
+	svm_capabilities			= 0;
 	vendor_id					= 0;
 	warp_size					= 0;
 	wavefront_width				= 0;
@@ -31,10 +36,13 @@ void DeviceInfo::print() const
 	std::cout << "  max work group size " << max_workgroup_size << std::endl;
 	std::cout << "  max work item sizes [" << max_work_item_sizes[0] << ", " << max_work_item_sizes[1] << ", " << max_work_item_sizes[2] << "]" << std::endl;
 	std::cout << "  max mem alloc size " << (max_mem_alloc_size >> 20) << " MB" << std::endl;
+	std::cout << "  local mem size " << (local_mem_size >> 10) << " KB" << std::endl;
 	if (warp_size != 0)
 		std::cout << "  warp size " << warp_size << std::endl;
 	if (wavefront_width != 0)
 		std::cout << "  wavefront width " << wavefront_width << std::endl;
+	if (hasSVM())
+		std::cout << "  " << (hasFineGrainedSVM() ? "fine" : "coarse") << "-grained shared virtual memory" << std::endl;
 }
 
 void DeviceInfo::init(cl_device_id device_id)
@@ -46,7 +54,9 @@ void DeviceInfo::init(cl_device_id device_id)
 	cl_uint			vendor_id					= 0;
 	cl_ulong		max_mem_alloc_size			= 0;
 	cl_ulong		global_mem_size				= 0;
+	cl_ulong		local_mem_size				= 0;
 	cl_uint			device_address_bits			= 0;
+	cl_uint			mem_base_addr_align			= 0;
 	char			device_string[1024]			= "";
 	char			vendor_string[1024]			= "";
 	char			driver_version_string[1024] = "";
@@ -66,8 +76,10 @@ void DeviceInfo::init(cl_device_id device_id)
 	OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS,	sizeof(max_work_item_dimensions),	&max_work_item_dimensions, NULL));
 	OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_GROUP_SIZE,			sizeof(max_workgroup_size),			&max_workgroup_size, NULL));
 	OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_GLOBAL_MEM_SIZE,				sizeof(global_mem_size),			&global_mem_size, NULL));
+	OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_LOCAL_MEM_SIZE,				sizeof(local_mem_size),				&local_mem_size, NULL));
 	OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_ADDRESS_BITS,				sizeof(device_address_bits),		&device_address_bits, NULL));
 	OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_VENDOR_ID,					sizeof(vendor_id),					&vendor_id, NULL));
+	OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_MEM_BASE_ADDR_ALIGN,			sizeof(mem_base_addr_align),		&mem_base_addr_align, NULL));
 
 	std::vector<size_t> max_work_item_sizes(max_work_item_dimensions);
 	OCL_SAFE_CALL(clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_ITEM_SIZES, max_work_item_dimensions * sizeof(size_t), max_work_item_sizes.data(), NULL));
@@ -82,7 +94,9 @@ void DeviceInfo::init(cl_device_id device_id)
 	this->max_mem_alloc_size		= max_mem_alloc_size;
 	this->max_workgroup_size		= max_workgroup_size;
 	this->global_mem_size			= global_mem_size;
+	this->local_mem_size			= local_mem_size;
 	this->device_address_bits		= device_address_bits;
+	this->mem_base_addr_align		= mem_base_addr_align / 8;
 	this->max_work_item_dimensions	= max_work_item_dimensions;
 	this->driver_version			= std::string(driver_version_string);
 	this->platform_version			= std::string(platform_version_string);
@@ -107,6 +121,17 @@ void DeviceInfo::init(cl_device_id device_id)
 
 	this->warp_size			= warp_size;
 	this->wavefront_width	= wavefront_width;
+
+	// since OpenCL 1.1, CPU devices always share memory with the host
+	cl_bool host_unified_memory = CL_FALSE;
+	if (clGetDeviceInfo(device_id, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(host_unified_memory), &host_unified_memory, NULL) != CL_SUCCESS)
+		host_unified_memory = CL_FALSE;
+	this->host_unified_memory = host_unified_memory || device_type == CL_DEVICE_TYPE_CPU;
+
+	cl_device_svm_capabilities svm_capabilities = 0;
+	if (opencl_major_version >= 2 && clGetDeviceInfo(device_id, CL_DEVICE_SVM_CAPABILITIES, sizeof(svm_capabilities), &svm_capabilities, NULL) != CL_SUCCESS)
+		svm_capabilities = 0;
+	this->svm_capabilities = svm_capabilities;
 }
 
 void DeviceInfo::initOpenCLVersion(cl_platform_id platform_id, cl_device_id device_id)
@@ -170,6 +195,16 @@ bool DeviceInfo::isIntelGPU() const
 		   && (vendor_id == ocl::ID_INTEL || vendor_name.find("Intel") != std::string::npos);
 }
 
+bool DeviceInfo::hasSVM() const
+{
+	return (svm_capabilities & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER) != 0;
+}
+
+bool DeviceInfo::hasFineGrainedSVM() const
+{
+	return (svm_capabilities & CL_DEVICE_SVM_FINE_GRAIN_BUFFER) != 0;
+}
+
 void DeviceInfo::initExtensions(cl_platform_id platform_id, cl_device_id device_id)
 {
 	for (int i = 0; i < 2; ++i) {
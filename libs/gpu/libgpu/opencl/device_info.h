@@ -17,6 +17,8 @@ public:
 	void print() const;
 
 	bool 				isIntelGPU() const;
+	bool				hasSVM() const;
+	bool				hasFineGrainedSVM() const;
 	bool				hasExtension(std::string extension)	{ return extensions.count(extension) > 0;}
 
 	std::string				device_name;
@@ -28,7 +30,11 @@ public:
 	size_t					max_workgroup_size;
 	size_t					max_work_item_sizes[3];
 	size_t					global_mem_size;
+	size_t					local_mem_size;
 	size_t 					device_address_bits;
+	size_t					mem_base_addr_align;	// in bytes, sub-buffer offsets must be multiple of it
+	bool					host_unified_memory;	// CPU and integrated devices, buffers can be used by the host without copies
+	unsigned long long		svm_capabilities;		// CL_DEVICE_SVM_CAPABILITIES bits, 0 before OpenCL 2.0
 	size_t					max_work_item_dimensions;
 	unsigned int			warp_size;
 	size_t					wavefront_width;
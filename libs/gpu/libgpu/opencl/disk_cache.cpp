@@ -0,0 +1,251 @@
+#include "disk_cache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <fstream>
+#include <libutils/string_utils.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace ocl {
+
+static const char entry_magic[8] = {'L', 'G', 'P', 'U', 'C', 'H', '0', '1'};
+
+static std::string defaultDirectory()
+{
+	const char *dir = getenv("LIBGPU_CACHE_DIR");
+	if (dir)
+		return std::string(dir);
+
+#ifdef _WIN32
+	const char *appdata = getenv("LOCALAPPDATA");
+	if (appdata && *appdata)
+		return std::string(appdata) + "\\libgpu";
+#else
+	const char *xdg = getenv("XDG_CACHE_HOME");
+	if (xdg && *xdg)
+		return std::string(xdg) + "/libgpu";
+
+	const char *home = getenv("HOME");
+	if (home && *home)
+		return std::string(home) + "/.cache/libgpu";
+#endif
+
+	return std::string();
+}
+
+static bool makeDirectories(const std::string &path)
+{
+	for (size_t i = 1; i <= path.size(); ++i) {
+		if (i != path.size() && path[i] != '/' && path[i] != '\\')
+			continue;
+
+		std::string dir = path.substr(0, i);
+#ifdef _WIN32
+		if (dir.size() == 2 && dir[1] == ':')
+			continue;
+		_mkdir(dir.c_str());
+#else
+		if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+			return false;
+#endif
+	}
+	return true;
+}
+
+bool DiskCache::enabled()
+{
+	return !directory().empty();
+}
+
+static std::string initDirectory()
+{
+	std::string dir = defaultDirectory();
+	if (!dir.empty() && !makeDirectories(dir))
+		dir.clear();
+	return dir;
+}
+
+const std::string &DiskCache::directory()
+{
+	static const std::string dir = initDirectory();
+	return dir;
+}
+
+std::string DiskCache::path(const std::string &key)
+{
+	std::string name = key;
+	for (size_t i = 0; i < name.size(); ++i) {
+		char c = name[i];
+		bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+		if (!safe)
+			name[i] = '_';
+	}
+	return directory() + "/" + name;
+}
+
+unsigned long long DiskCache::hash(const void *data, size_t size, unsigned long long seed)
+{
+	// 64-bit FNV-1a
+	const unsigned char *bytes = (const unsigned char *) data;
+	unsigned long long h = seed;
+	for (size_t i = 0; i < size; ++i) {
+		h ^= bytes[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+std::string DiskCache::hashString(unsigned long long hash)
+{
+	char buffer[17];
+	sprintf(buffer, "%016llx", hash);
+	return std::string(buffer);
+}
+
+bool DiskCache::load(const std::string &key, std::vector<unsigned char> &data)
+{
+	if (!enabled())
+		return false;
+
+	std::ifstream file(path(key).c_str(), std::ios::binary);
+	if (!file)
+		return false;
+
+	char magic[sizeof(entry_magic)];
+	unsigned long long size = 0, checksum = 0;
+	file.read(magic, sizeof(magic));
+	file.read((char *) &size, sizeof(size));
+	file.read((char *) &checksum, sizeof(checksum));
+
+	bool valid = file && memcmp(magic, entry_magic, sizeof(entry_magic)) == 0;
+	if (valid) {
+		data.resize(size);
+		file.read((char *) data.data(), size);
+		valid = file && file.gcount() == (std::streamsize) size && hash(data.data(), data.size()) == checksum;
+	}
+	file.close();
+
+	if (!valid) {
+		data.clear();
+		remove(key);
+	}
+	return valid;
+}
+
+void DiskCache::store(const std::string &key, const std::vector<unsigned char> &data)
+{
+	if (!enabled())
+		return;
+
+	static std::atomic<int> counter(0);
+#ifdef _WIN32
+	int pid = _getpid();
+#else
+	int pid = getpid();
+#endif
+	std::string filename = path(key);
+	std::string tmp_filename = filename + ".tmp" + to_string(pid) + "_" + to_string(counter++);
+
+	unsigned long long size = data.size();
+	unsigned long long checksum = hash(data.data(), data.size());
+
+	{
+		std::ofstream file(tmp_filename.c_str(), std::ios::binary | std::ios::trunc);
+		file.write(entry_magic, sizeof(entry_magic));
+		file.write((const char *) &size, sizeof(size));
+		file.write((const char *) &checksum, sizeof(checksum));
+		file.write((const char *) data.data(), data.size());
+		file.close();
+
+		if (!file) {
+			std::remove(tmp_filename.c_str());
+			return;
+		}
+	}
+
+	// the cache is best-effort, failures are ignored
+#ifdef _WIN32
+	if (!MoveFileExA(tmp_filename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+		std::remove(tmp_filename.c_str());
+#else
+	if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+		std::remove(tmp_filename.c_str());
+#endif
+}
+
+void DiskCache::remove(const std::string &key)
+{
+	if (!enabled())
+		return;
+
+	std::remove(path(key).c_str());
+}
+
+DiskCache::KeyLock::KeyLock(const std::string &key)
+{
+#ifdef _WIN32
+	handle_ = INVALID_HANDLE_VALUE;
+	if (!enabled())
+		return;
+
+	handle_ = CreateFileA((path(key) + ".lock").c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+						  NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle_ != INVALID_HANDLE_VALUE) {
+		OVERLAPPED overlapped = {0};
+		if (!LockFileEx(handle_, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped)) {
+			CloseHandle(handle_);
+			handle_ = INVALID_HANDLE_VALUE;
+		}
+	}
+#else
+	fd_ = -1;
+	if (!enabled())
+		return;
+
+	fd_ = open((path(key) + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd_ != -1) {
+		int res;
+		do {
+			res = flock(fd_, LOCK_EX);
+		} while (res != 0 && errno == EINTR);
+
+		if (res != 0) {
+			close(fd_);
+			fd_ = -1;
+		}
+	}
+#endif
+}
+
+DiskCache::KeyLock::~KeyLock()
+{
+	// lock files are left in place: unlinking them would race with processes waiting on the same file
+#ifdef _WIN32
+	if (handle_ != INVALID_HANDLE_VALUE) {
+		OVERLAPPED overlapped = {0};
+		UnlockFileEx(handle_, 0, 1, 0, &overlapped);
+		CloseHandle(handle_);
+	}
+#else
+	if (fd_ != -1) {
+		flock(fd_, LOCK_UN);
+		close(fd_);
+	}
+#endif
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace ocl {
+
+// Persistent key-value storage in a directory shared between processes (compiled program binaries, tuning results).
+// The directory is $LIBGPU_CACHE_DIR (empty value disables the cache), by default $XDG_CACHE_HOME/libgpu, ~/.cache/libgpu
+// or %LOCALAPPDATA%\libgpu. Entries are written atomically (temporary file + rename) and checksummed,
+// so concurrent readers see either a complete entry or no entry at all.
+class DiskCache {
+public:
+	// Exclusive inter-process lock of a single key, e.g. to compile a program only once when several processes start together
+	class KeyLock {
+	public:
+		explicit KeyLock(const std::string &key);
+		~KeyLock();
+
+	protected:
+		KeyLock(const KeyLock &);
+		KeyLock &operator= (const KeyLock &);
+
+#ifdef _WIN32
+		void *					handle_;
+#else
+		int						fd_;
+#endif
+	};
+
+	static bool					enabled();
+	static const std::string &	directory();
+
+	// Returns false if there is no such entry or it is corrupted (corrupted entries are removed)
+	static bool					load(const std::string &key, std::vector<unsigned char> &data);
+	static void					store(const std::string &key, const std::vector<unsigned char> &data);
+	static void					remove(const std::string &key);
+
+	static unsigned long long	hash(const void *data, size_t size, unsigned long long seed = 14695981039346656037ULL);
+	static std::string			hashString(unsigned long long hash);
+
+protected:
+	static std::string			path(const std::string &key);
+};
+
+}
@@ -8,19 +8,22 @@
 #include <sstream>
 #include <cassert>
 #include <vector>
+#include <atomic>
 
 #include <libclew/ocl_init.h>
+#include <libclew/ocl_svm.h>
 
 #include <CL/cl.h>
 #include <CL/cl_ext.h>
 #include <libgpu/context.h>
 #include <libgpu/shared_device_buffer.h>
+#include <libgpu/shared_svm_buffer.h>
+#include <libgpu/opencl/disk_cache.h>
+#include <libgpu/opencl/kernel_registry.h>
 #include <libutils/timer.h>
 
 #define _SHORT_FILE_ "ocl_engine.cpp"
 
-#define LOAD_KERNEL_BINARIES_FROM_FILE ""
-#define DUMP_KERNEL_BINARIES_TO_FILE ""
 #define OCL_VERBOSE_COMPILE_LOG false
 
 #ifdef _MSC_VER
@@ -63,10 +66,15 @@ cl_platform_id oclGetPlatformID(void)
 	return platform;
 }
 
+static std::atomic<unsigned int> mem_objects_generation(0);
+
 OpenCLKernel::OpenCLKernel()
 {
 	kernel_				= 0;
 	work_group_size_	= 0;
+	preferred_work_group_size_multiple_	= 1;
+	args_bound_			= 0;
+	args_skipped_		= 0;
 }
 
 OpenCLKernel::~OpenCLKernel()
@@ -96,6 +104,67 @@ void OpenCLKernel::create(cl_program program, const char *kernel_name, cl_device
 		throw std::runtime_error("clGetKernelWorkGroupInfo failed: " + errorString(ciErrNum));
 
 	work_group_size_ = kernel_workgroup_size;
+
+	// since OpenCL 1.1
+	size_t preferred_multiple = 0;
+	ciErrNum = clGetKernelWorkGroupInfo(kernel_, device_id_, CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE, sizeof(size_t), &preferred_multiple, NULL);
+	if (ciErrNum == CL_SUCCESS && preferred_multiple > 0)
+		preferred_work_group_size_multiple_ = preferred_multiple;
+}
+
+void OpenCLKernel::invalidateMemArgs()
+{
+	++mem_objects_generation;
+}
+
+void OpenCLKernel::setArgArray(const Arg *args, size_t nargs)
+{
+	unsigned int mem_generation = mem_objects_generation.load();
+
+	if (bound_args_.size() < nargs)
+		bound_args_.resize(nargs);
+
+	for (size_t i = 0; i < nargs; ++i)
+		setArg((cl_uint) i, args[i], mem_generation);
+}
+
+void OpenCLKernel::setArg(cl_uint arg_index, const Arg &arg, unsigned int mem_generation)
+{
+	if (arg.is_null)
+		return;
+
+	BoundArg &bound = bound_args_[arg_index];
+	bool is_mem = arg.isMemObject();
+
+	if (bound.valid && bound.size == arg.size && bound.is_mem == is_mem && bound.is_svm == arg.is_svm && (!is_mem || bound.mem_generation == mem_generation)) {
+		bool same_value = arg.value ? (bound.value.size() == arg.size && memcmp(bound.value.data(), arg.value, arg.size) == 0)
+									: bound.value.empty();
+		if (same_value) {
+			++args_skipped_;
+			return;
+		}
+	}
+
+	bound.valid = false;
+	if (arg.is_svm) {
+		cl_int ciErrNum = clSetKernelArgSVMPointer(kernel_, arg_index, arg.svmPointer());
+		if (ciErrNum != CL_SUCCESS)
+			throw std::runtime_error("clSetKernelArgSVMPointer " + to_string(kernel_name_) + "#" + to_string(arg_index) + " failed: " + errorString(ciErrNum));
+	} else {
+		setArg(arg_index, arg.size, arg.value);
+	}
+	++args_bound_;
+
+	bound.valid				= true;
+	bound.is_mem			= is_mem;
+	bound.is_svm			= arg.is_svm;
+	bound.mem_generation	= mem_generation;
+	bound.size				= arg.size;
+	if (arg.value) {
+		bound.value.assign((const unsigned char *) arg.value, (const unsigned char *) arg.value + arg.size);
+	} else {
+		bound.value.clear();
+	}
 }
 
 void OpenCLKernel::setArg(cl_uint arg_index, size_t arg_size, const void *arg_value)
@@ -106,6 +175,11 @@ void OpenCLKernel::setArg(cl_uint arg_index, size_t arg_size, const void *arg_va
 		throw std::runtime_error("clSetKernelArg " + to_string(kernel_name_) + "#" + to_string(arg_index) + " (" +to_string(arg_size) + " bytes) failed: " + errorString(ciErrNum));
 }
 
+namespace {
+	// pending events are first compacted at this count, see OpenCLEngine::trackEventAsync()
+	const size_t min_pending_events_limit = 1024;
+}
+
 OpenCLEngine::OpenCLEngine()
 {
 	platform_id_				= 0;
@@ -113,15 +187,22 @@ OpenCLEngine::OpenCLEngine()
 	context_					= 0;
 	command_queue_				= 0;
 	total_mem_size_				= 0;
+	profiling_					= false;
+	pending_events_limit_		= min_pending_events_limit;
+	buffer_pool_				= std::make_shared<BufferPool>();
 }
 
 OpenCLEngine::~OpenCLEngine()
 {
-	for (std::map<int, OpenCLKernel *>::iterator it = kernels_.begin(); it != kernels_.end(); ++it)
-		delete it->second;
+	// buffers that are still alive are released on their destruction
+	buffer_pool_->setQueues(std::vector<cl_command_queue>());
+	buffer_pool_->trim();
+
+	kernels_.forEach([](OpenCLKernel *kernel) { delete kernel; });
+	programs_.forEach([](cl_program program) { clReleaseProgram(program); });
 
-	for (std::map<int, cl_program>::iterator it = programs_.begin(); it != programs_.end(); ++it)
-		clReleaseProgram(it->second);
+	for (std::map<std::string, cl_command_queue>::iterator it = queues_.begin(); it != queues_.end(); ++it)
+		clReleaseCommandQueue(it->second);
 
 	if (command_queue_)		clReleaseCommandQueue(command_queue_);
 	if (context_)			clReleaseContext(context_);
@@ -145,6 +226,11 @@ void OpenCLEngine::init(cl_platform_id platform_id, cl_device_id device_id, cons
 	if (!ocl_init())
 		throw ocl_exception("Can't init OpenCL driver");
 
+	buffer_pool_->setQueues(std::vector<cl_command_queue>());
+	for (std::map<std::string, cl_command_queue>::iterator it = queues_.begin(); it != queues_.end(); ++it)
+		clReleaseCommandQueue(it->second);
+	queues_.clear();
+
 	if (command_queue_) {
 		clReleaseCommandQueue(command_queue_);
 		command_queue_ = 0;
@@ -182,6 +268,8 @@ void OpenCLEngine::init(cl_platform_id platform_id, cl_device_id device_id, cons
 		throw ocl_exception("3 dimensional work items not supported");
 
 	total_mem_size_ = device_info_.global_mem_size;
+	buffer_pool_->setMaxCachedBytes(total_mem_size_ / 4);
+	buffer_pool_->setBaseAddressAlignment(device_info_.mem_base_addr_align);
 
 	cl_context_properties context_props[] = { CL_CONTEXT_PLATFORM, (cl_context_properties) platform_id, 0 };
 
@@ -189,8 +277,9 @@ void OpenCLEngine::init(cl_platform_id platform_id, cl_device_id device_id, cons
 	context_		= clCreateContext(context_props, 1, &device_id, NULL, NULL, &ciErrNum);
 	OCL_SAFE_CALL(ciErrNum);
 
-	command_queue_	= clCreateCommandQueue(context_, device_id, 0, &ciErrNum);
+	command_queue_	= clCreateCommandQueue(context_, device_id, queueProperties(), &ciErrNum);
 	OCL_SAFE_CALL(ciErrNum);
+	updatePoolQueues();
 
 	platform_id_	= platform_id;
 	device_id_		= device_id;
@@ -273,7 +362,15 @@ void OpenCLEngine::writeBuffer(cl_mem buffer, cl_bool blocking_write, size_t off
 {
 	if (cb == 0)
 		return;
-	OCL_SAFE_CALL(clEnqueueWriteBuffer(queue(), buffer, blocking_write, offset, cb, ptr, 0, NULL, NULL));
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueWriteBuffer(queue(), buffer, blocking_write, offset, cb, ptr, 0, NULL, profilingEvent(&ev)));
+	if (ev) {
+		if (blocking_write) {
+			trackEvent(ev, "Write buffer: ", "transfer H2D", cb);
+		} else {
+			trackEventAsync(ev, "Write buffer: ", "transfer H2D", cb);
+		}
+	}
 }
 
 void OpenCLEngine::writeBufferRect(cl_mem buffer, cl_bool blocking_write, const size_t buffer_origin[3], const size_t host_origin[3], const size_t region[3],
@@ -289,7 +386,15 @@ void OpenCLEngine::readBuffer(cl_mem buffer, cl_bool blocking_read, size_t offse
 {
 	if (cb == 0)
 		return;
-	OCL_SAFE_CALL(clEnqueueReadBuffer(queue(), buffer, blocking_read, offset, cb, ptr, 0, NULL, NULL));
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueReadBuffer(queue(), buffer, blocking_read, offset, cb, ptr, 0, NULL, profilingEvent(&ev)));
+	if (ev) {
+		if (blocking_read) {
+			trackEvent(ev, "Read buffer: ", "transfer D2H", cb);
+		} else {
+			trackEventAsync(ev, "Read buffer: ", "transfer D2H", cb);
+		}
+	}
 }
 
 void OpenCLEngine::readBufferRect(cl_mem buffer, cl_bool blocking_write, const size_t buffer_origin[3], const size_t host_origin[3], const size_t region[3],
@@ -307,7 +412,149 @@ void OpenCLEngine::copyBuffer(cl_mem src_buffer, cl_mem dst_buffer, size_t src_o
 		return;
 	cl_event ev = NULL;
 	OCL_SAFE_CALL(clEnqueueCopyBuffer(queue(), src_buffer, dst_buffer, src_offset, dst_offset, cb, 0, NULL, &ev));
-	trackEvent(ev);
+	trackEvent(ev, "Copy buffer: ", "transfer D2D", cb);
+}
+
+void *OpenCLEngine::mapBuffer(cl_mem buffer, cl_map_flags flags, size_t offset, size_t cb)
+{
+	cl_int status = CL_SUCCESS;
+	void *res = clEnqueueMapBuffer(queue(), buffer, CL_TRUE, flags, offset, cb, 0, NULL, NULL, &status);
+	OCL_SAFE_CALL(status);
+	if (!res)
+		throw ocl_exception("Can't map buffer of " + to_string(cb) + " bytes!");
+	return res;
+}
+
+void OpenCLEngine::unmapBuffer(cl_mem buffer, void *ptr)
+{
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueUnmapMemObject(queue(), buffer, ptr, 0, NULL, &ev));
+	trackEvent(ev, "Unmap buffer: ", "unmap");
+}
+
+void *OpenCLEngine::svmAlloc(cl_bitfield flags, size_t size)
+{
+	if (!device_info_.hasSVM())
+		return 0;
+
+	void *res = clSVMAlloc(context_, CL_MEM_READ_WRITE | flags, size, 0);
+	if (!res)
+		throw ocl_bad_alloc("Can't allocate " + to_string(size) + " bytes of shared virtual memory!");
+	return res;
+}
+
+void OpenCLEngine::svmFree(void *ptr)
+{
+	if (!ptr)
+		return;
+
+	// clSVMFree does not wait for commands using the memory, they may be on any queue
+	OCL_SAFE_CALL(clFinish(queue()));
+	{
+		Lock lock(queues_mutex_);
+		for (std::map<std::string, cl_command_queue>::const_iterator it = queues_.begin(); it != queues_.end(); ++it)
+			OCL_SAFE_CALL_MESSAGE(clFinish(it->second), "Queue " + it->first + ": ");
+	}
+	clSVMFree(context_, ptr);
+}
+
+void OpenCLEngine::svmMap(void *ptr, cl_map_flags flags, size_t size)
+{
+	OCL_SAFE_CALL(clEnqueueSVMMap(queue(), CL_TRUE, flags, ptr, size, 0, NULL, NULL));
+}
+
+void OpenCLEngine::svmUnmap(void *ptr)
+{
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueSVMUnmap(queue(), ptr, 0, NULL, &ev));
+	trackEvent(ev, "Unmap SVM: ", "unmap");
+}
+
+OpenCLEvent OpenCLEngine::writeBufferAsync(cl_mem buffer, size_t offset, size_t cb, const void *ptr, const OpenCLStream &stream)
+{
+	if (cb == 0)
+		return OpenCLEvent();
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueWriteBuffer(queueOf(stream), buffer, CL_FALSE, offset, cb, ptr, (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), &ev));
+	return trackEventAsync(ev, "Write buffer: ", "transfer H2D", cb);
+}
+
+OpenCLEvent OpenCLEngine::readBufferAsync(cl_mem buffer, size_t offset, size_t cb, void *ptr, const OpenCLStream &stream)
+{
+	if (cb == 0)
+		return OpenCLEvent();
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueReadBuffer(queueOf(stream), buffer, CL_FALSE, offset, cb, ptr, (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), &ev));
+	return trackEventAsync(ev, "Read buffer: ", "transfer D2H", cb);
+}
+
+OpenCLEvent OpenCLEngine::copyBufferAsync(cl_mem src_buffer, cl_mem dst_buffer, size_t src_offset, size_t dst_offset, size_t cb, const OpenCLStream &stream)
+{
+	if (cb == 0)
+		return OpenCLEvent();
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueCopyBuffer(queueOf(stream), src_buffer, dst_buffer, src_offset, dst_offset, cb, (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), &ev));
+	return trackEventAsync(ev, "Copy buffer: ", "transfer D2D", cb);
+}
+
+void OpenCLEngine::enqueueWriteBuffer(cl_mem buffer, size_t offset, size_t cb, const void *ptr, const OpenCLStream &stream)
+{
+	if (cb == 0)
+		return;
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueWriteBuffer(queueOf(stream), buffer, CL_FALSE, offset, cb, ptr, (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), profilingEvent(&ev)));
+	if (ev)
+		trackEventAsync(ev, "Write buffer: ", "transfer H2D", cb);
+}
+
+void OpenCLEngine::enqueueReadBuffer(cl_mem buffer, size_t offset, size_t cb, void *ptr, const OpenCLStream &stream)
+{
+	if (cb == 0)
+		return;
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueReadBuffer(queueOf(stream), buffer, CL_FALSE, offset, cb, ptr, (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), profilingEvent(&ev)));
+	if (ev)
+		trackEventAsync(ev, "Read buffer: ", "transfer D2H", cb);
+}
+
+void OpenCLEngine::enqueueCopyBuffer(cl_mem src_buffer, cl_mem dst_buffer, size_t src_offset, size_t dst_offset, size_t cb, const OpenCLStream &stream)
+{
+	if (cb == 0)
+		return;
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueCopyBuffer(queueOf(stream), src_buffer, dst_buffer, src_offset, dst_offset, cb, (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), profilingEvent(&ev)));
+	if (ev)
+		trackEventAsync(ev, "Copy buffer: ", "transfer D2D", cb);
+}
+
+void OpenCLEngine::enqueueNDRangeKernel(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
+										const size_t *global_work_size, const size_t *local_work_size, const OpenCLStream &stream)
+{
+	checkNDRange(kernel, work_dim, global_work_size, local_work_size);
+
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueNDRangeKernel(queueOf(stream), kernel.kernel(), work_dim, global_work_offset, global_work_size, local_work_size,
+										 (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), profilingEvent(&ev)));
+	if (ev)
+		trackEventAsync(ev, "Kernel " + kernel.kernelName() + ": ", kernel.kernelName());
+}
+
+OpenCLEvent OpenCLEngine::marker(const OpenCLStream &stream)
+{
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	if (!wait_list.empty())
+		OCL_SAFE_CALL(clEnqueueWaitForEvents(queueOf(stream), (cl_uint) wait_list.size(), wait_list.data()));
+
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueMarker(queueOf(stream), &ev));
+	return trackEventAsync(ev, "Marker: ", "marker");
 }
 
 void OpenCLEngine::releaseMemObject(cl_mem memobj)
@@ -316,10 +563,52 @@ void OpenCLEngine::releaseMemObject(cl_mem memobj)
 		return;
 
 	OCL_SAFE_CALL(clReleaseMemObject(memobj));
+	OpenCLKernel::invalidateMemArgs();
 }
 
 void OpenCLEngine::ndRangeKernel(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
 								 const size_t *global_work_size, const size_t *local_work_size)
+{
+	checkNDRange(kernel, work_dim, global_work_size, local_work_size);
+
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueNDRangeKernel(queue(), kernel.kernel(), work_dim, global_work_offset, global_work_size, local_work_size, 0, NULL, &ev));
+	trackEvent(ev, "Kernel " + kernel.kernelName() + ": ", kernel.kernelName());
+}
+
+OpenCLEvent OpenCLEngine::ndRangeKernelAsync(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
+											 const size_t *global_work_size, const size_t *local_work_size, const OpenCLStream &stream)
+{
+	checkNDRange(kernel, work_dim, global_work_size, local_work_size);
+
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueNDRangeKernel(queueOf(stream), kernel.kernel(), work_dim, global_work_offset, global_work_size, local_work_size,
+										 (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), &ev));
+	return trackEventAsync(ev, "Kernel " + kernel.kernelName() + ": ", kernel.kernelName());
+}
+
+OpenCLEvent OpenCLEngine::ndRangeKernelUntracked(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
+												 const size_t *global_work_size, const size_t *local_work_size, const OpenCLStream &stream)
+{
+	checkNDRange(kernel, work_dim, global_work_size, local_work_size);
+
+	std::vector<cl_event> wait_list = stream.waitEvents();
+	cl_event ev = NULL;
+	OCL_SAFE_CALL(clEnqueueNDRangeKernel(queueOf(stream), kernel.kernel(), work_dim, global_work_offset, global_work_size, local_work_size,
+										 (cl_uint) wait_list.size(), wait_list.empty() ? NULL : wait_list.data(), &ev));
+	return OpenCLEvent(ev, "Kernel " + kernel.kernelName() + ": ");
+}
+
+void OpenCLEngine::waitUntracked(const OpenCLEvent &event, const std::string &name, size_t bytes)
+{
+	event.wait();
+
+	if (profiling_)
+		profiler_.record(name, event.event(), bytes);
+}
+
+void OpenCLEngine::checkNDRange(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_size, const size_t *local_work_size)
 {
 	if (work_dim < 1 || work_dim > 3)
 		throw ocl_exception("Wrong work dimension size: " + to_string(work_dim) + "!");
@@ -352,13 +641,9 @@ void OpenCLEngine::ndRangeKernel(OpenCLKernel &kernel, cl_uint work_dim, const s
 								+ to_string(global_work_size[d]) + ", while device has " + to_string(device_info_.device_address_bits) + " address bits!");
 		}
 	}
-
-	cl_event ev = NULL;
-	OCL_SAFE_CALL(clEnqueueNDRangeKernel(queue(), kernel.kernel(), work_dim, global_work_offset, global_work_size, local_work_size, 0, NULL, &ev));
-	trackEvent(ev, "Kernel " + kernel.kernelName() + ": ");
 }
 
-void OpenCLEngine::trackEvent(cl_event ev, std::string message)
+void OpenCLEngine::trackEvent(cl_event ev, std::string message, std::string name, size_t bytes)
 {
 	cl_int		ciErrNum	= CL_SUCCESS;
 	cl_int		result		= CL_SUCCESS;
@@ -371,6 +656,9 @@ void OpenCLEngine::trackEvent(cl_event ev, std::string message)
 		if (result != CL_COMPLETE) {
 			throw ocl_exception("Wait for event succeed, but it is still is not complete with execution status: " + to_string(result) + "!");
 		}
+
+		if (profiling_)
+			profiler_.record(name, ev, bytes);
 	} catch (...) {
 		OCL_SAFE_CALL_MESSAGE(clReleaseEvent(ev), message);
 		throw;
@@ -379,20 +667,137 @@ void OpenCLEngine::trackEvent(cl_event ev, std::string message)
 	OCL_SAFE_CALL_MESSAGE(clReleaseEvent(ev), message);
 }
 
-cl_program OpenCLEngine::findProgram(int id) const
+OpenCLEvent OpenCLEngine::trackEventAsync(cl_event ev, std::string message, std::string name, size_t bytes)
 {
-	std::map<int, cl_program>::const_iterator it = programs_.find(id);
-	if (it != programs_.end())
-		return it->second;
-	return 0;
+	PendingEvent pending;
+	pending.event	= OpenCLEvent(ev, message);
+	pending.name	= name;
+	pending.bytes	= bytes;
+
+	Lock lock(pending_events_mutex_);
+
+	// dropping successfully completed events, failed ones are kept until finish(). The limit is at least twice the number
+	// of kept events, so that rescans of long-running or failed events are amortized over the submissions between them
+	if (pending_events_.size() >= pending_events_limit_) {
+		size_t k = 0;
+		for (size_t i = 0; i < pending_events_.size(); ++i) {
+			if (pending_events_[i].event.status() != CL_COMPLETE) {
+				std::swap(pending_events_[k++], pending_events_[i]);
+			} else if (profiling_) {
+				profiler_.record(pending_events_[i].name, pending_events_[i].event.event(), pending_events_[i].bytes);
+			}
+		}
+		pending_events_.resize(k);
+		pending_events_limit_ = std::max(min_pending_events_limit, 2 * k);
+	}
+
+	pending_events_.push_back(pending);
+	return pending.event;
 }
 
-OpenCLKernel *OpenCLEngine::findKernel(int id) const
+void OpenCLEngine::setProfilingEnabled(bool enabled)
 {
-	std::map<int, OpenCLKernel *>::const_iterator it = kernels_.find(id);
-	if (it != kernels_.end())
+	if (enabled == profiling_)
+		return;
+
+	if (command_queue_) {
+		finish();
+
+		cl_int ciErrNum = CL_SUCCESS;
+		cl_command_queue queue = clCreateCommandQueue(context_, device_id_, enabled ? CL_QUEUE_PROFILING_ENABLE : 0, &ciErrNum);
+		OCL_SAFE_CALL(ciErrNum);
+
+		Lock lock(queues_mutex_);
+		clReleaseCommandQueue(command_queue_);
+		command_queue_ = queue;
+		updatePoolQueues();
+	}
+
+	profiling_ = enabled;
+}
+
+cl_command_queue OpenCLEngine::queue(const std::string &name, cl_command_queue_properties properties)
+{
+	if (name.empty())
+		return queue();
+
+	Lock lock(queues_mutex_);
+
+	std::map<std::string, cl_command_queue>::const_iterator it = queues_.find(name);
+	if (it != queues_.end())
 		return it->second;
-	return 0;
+
+	cl_command_queue_properties supported_properties = 0;
+	OCL_SAFE_CALL(clGetDeviceInfo(device_id_, CL_DEVICE_QUEUE_PROPERTIES, sizeof(supported_properties), &supported_properties, NULL));
+
+	cl_int ciErrNum = CL_SUCCESS;
+	cl_command_queue res = clCreateCommandQueue(context_, device_id_, (properties | queueProperties()) & supported_properties, &ciErrNum);
+	OCL_SAFE_CALL_MESSAGE(ciErrNum, "Queue " + name + ": ");
+
+	queues_[name] = res;
+	updatePoolQueues();
+	return res;
+}
+
+void OpenCLEngine::updatePoolQueues()
+{
+	std::vector<cl_command_queue> queues;
+	if (command_queue_)
+		queues.push_back(command_queue_);
+	for (std::map<std::string, cl_command_queue>::const_iterator it = queues_.begin(); it != queues_.end(); ++it)
+		queues.push_back(it->second);
+
+	buffer_pool_->setQueues(queues);
+}
+
+void OpenCLEngine::flush()
+{
+	OCL_SAFE_CALL(clFlush(queue()));
+
+	Lock lock(queues_mutex_);
+	for (std::map<std::string, cl_command_queue>::const_iterator it = queues_.begin(); it != queues_.end(); ++it)
+		OCL_SAFE_CALL_MESSAGE(clFlush(it->second), "Queue " + it->first + ": ");
+}
+
+void OpenCLEngine::flush(const OpenCLStream &stream)
+{
+	OCL_SAFE_CALL(clFlush(queueOf(stream)));
+}
+
+void OpenCLEngine::finish()
+{
+	OCL_SAFE_CALL(clFinish(queue()));
+
+	{
+		Lock lock(queues_mutex_);
+		for (std::map<std::string, cl_command_queue>::const_iterator it = queues_.begin(); it != queues_.end(); ++it)
+			OCL_SAFE_CALL_MESSAGE(clFinish(it->second), "Queue " + it->first + ": ");
+	}
+
+	std::vector<PendingEvent> events;
+	{
+		Lock lock(pending_events_mutex_);
+		events.swap(pending_events_);
+		pending_events_limit_ = min_pending_events_limit;
+	}
+
+	for (size_t i = 0; i < events.size(); ++i) {
+		events[i].event.wait();
+		if (profiling_)
+			profiler_.record(events[i].name, events[i].event.event(), events[i].bytes);
+	}
+}
+
+void OpenCLEngine::addProgram(int id, cl_program program)
+{
+	if (!programs_.publish(id, program))
+		throw ocl_exception("Program " + to_string(id) + " is already built!");
+}
+
+void OpenCLEngine::addKernel(int id, OpenCLKernel *kernel)
+{
+	if (!kernels_.publish(id, kernel))
+		throw ocl_exception("Kernel " + to_string(id) + " is already created!");
 }
 
 VersionedBinary::VersionedBinary(const char *data, const size_t size,
@@ -402,20 +807,25 @@ VersionedBinary::VersionedBinary(const char *data, const size_t size,
 
 ProgramBinaries::ProgramBinaries(std::vector<VersionedBinary> binaries, std::string defines, std::string program_name) : binaries_(binaries)
 {
-	static int next_program_id = 0;
 	program_name_ = program_name;
-	id_			= next_program_id++;
+	id_			= getNextProgramId();
 	defines_	= defines;
 }
 
 ProgramBinaries::ProgramBinaries(const char *source_code, size_t source_code_length, std::string defines, std::string program_name) : binaries_({VersionedBinary(source_code, source_code_length, 0, 1, 2)})
 {
-	static int next_program_id = 0;
 	program_name_ = program_name;
-	id_			= next_program_id++;
+	id_			= getNextProgramId();
 	defines_	= defines;
 }
 
+int ProgramBinaries::getNextProgramId()
+{
+	// ids are dense, they index OpenCLEngine tables
+	static std::atomic<int> next_program_id(0);
+	return next_program_id++;
+}
+
 const VersionedBinary* ProgramBinaries::getBinary(const std::shared_ptr<OpenCLEngine> &cl) const
 {
 	for (int i = 0; i < binaries_.size(); ++i) {
@@ -441,17 +851,31 @@ KernelSource::KernelSource(std::shared_ptr<ocl::ProgramBinaries> program, const
 {
 	id_		= getNextKernelId();
 	name_	= std::string(name);
+	KernelRegistry::instance().add(this);
 }
 
 KernelSource::KernelSource(std::shared_ptr<ocl::ProgramBinaries> program, const std::string &name) : program_(program)
 {
 	id_		= getNextKernelId();
 	name_	= name;
+	KernelRegistry::instance().add(this);
+}
+
+KernelSource::KernelSource(const KernelSource &other) : program_(other.program_)
+{
+	id_		= other.id_;
+	name_	= other.name_;
+	KernelRegistry::instance().add(this);
+}
+
+KernelSource::~KernelSource()
+{
+	KernelRegistry::instance().remove(this);
 }
 
 int KernelSource::getNextKernelId()
 {
-	static int next_kernel_id = 0;
+	static std::atomic<int> next_kernel_id(0);
 	return next_kernel_id++;
 }
 
@@ -462,6 +886,7 @@ namespace ocl {
 
 	std::vector<unsigned char>* getCachedBinary(int programId, cl_platform_id platform, cl_device_id device)
 	{
+		Lock lock(cached_kernels_mutex);
 		auto programCacheIt = cached_kernels_binaries.find(programId);
 		if (programCacheIt == cached_kernels_binaries.end())
 			cached_kernels_binaries[programId] = binaries_by_device();
@@ -475,6 +900,7 @@ namespace ocl {
 
 	void setCachedBinary(int programId, cl_platform_id platform, cl_device_id device, std::vector<unsigned char> binaries)
 	{
+		Lock lock(cached_kernels_mutex);
 		auto programCacheIt = cached_kernels_binaries.find(programId);
 		if (programCacheIt == cached_kernels_binaries.end())
 			cached_kernels_binaries[programId] = binaries_by_device();
@@ -494,6 +920,46 @@ namespace ocl {
 
 		return binaries;
 	}
+
+	// Returns 0 if the binary was rejected by the driver, unless throw_on_error is set
+	cl_program createProgramWithBinary(const std::shared_ptr<OpenCLEngine> &cl, const unsigned char *data, size_t size, bool throw_on_error = false)
+	{
+		cl_device_id device = cl->device();
+		cl_int binary_status = CL_SUCCESS;
+		cl_int ciErrNum = CL_SUCCESS;
+
+		cl_program program = clCreateProgramWithBinary(cl->context(), 1, &device, &size, &data, &binary_status, &ciErrNum);
+		if (ciErrNum == CL_SUCCESS && binary_status != CL_SUCCESS) {
+			clReleaseProgram(program);
+			ciErrNum = binary_status;
+		}
+
+		if (ciErrNum != CL_SUCCESS) {
+			if (throw_on_error)
+				OCL_SAFE_CALL(ciErrNum);
+			return 0;
+		}
+		return program;
+	}
+
+	// Compiled binary is valid only for the same sources, build options, device and driver
+	unsigned long long programHash(const VersionedBinary *binary, const std::string &options, const DeviceInfo &device_info)
+	{
+		std::string environment = options + '\n' + device_info.device_name + '\n' + device_info.driver_version;
+
+		unsigned long long hash = DiskCache::hash(binary->data(), binary->size());
+		return DiskCache::hash(environment.data(), environment.size(), hash);
+	}
+
+	std::string programCacheKey(const VersionedBinary *binary, const std::string &options, const DeviceInfo &device_info)
+	{
+		return "program_" + DiskCache::hashString(programHash(binary, options, device_info)) + ".bin";
+	}
+
+	std::string programOptions(const ProgramBinaries &program, const OpenCLEngine &cl)
+	{
+		return program.defines() + " -D WARP_SIZE=" + to_string(cl.wavefrontSize());
+	}
 }
 
 OpenCLKernel *KernelSource::getKernel(const std::shared_ptr<OpenCLEngine> &cl, bool printLog)
@@ -502,155 +968,193 @@ OpenCLKernel *KernelSource::getKernel(const std::shared_ptr<OpenCLEngine> &cl, b
 	if (kernel)
 		return kernel;
 
+	// different programs are built concurrently, the same program is built only once
+	Lock lock(program_->buildMutex());
+
+	kernel = cl->findKernel(id_);
+	if (kernel)
+		return kernel;
+
 	cl_program program = cl->findProgram(program_->id());
 
 	if (!program) {
-		Lock lock(cached_kernels_mutex);
-
 		bool verbose = printLog || OCL_VERBOSE_COMPILE_LOG;
 
 		const VersionedBinary* binary = program_->getBinary(cl);
-		const std::vector<unsigned char>* cachedCompiledBinary = getCachedBinary(program_->id(), cl->platform(), cl->device());
-
-		cl_int ciErrNum = CL_SUCCESS;
-
-		std::string options = program_->defines();
 
-		std::vector<unsigned char> loaded_from_file_binaries;
-		std::string binaries_to_load_filename = LOAD_KERNEL_BINARIES_FROM_FILE;
+		if (binary->deviceAddressBits() != 0 && cl->deviceInfo().extensions.count("cl_khr_spir") == 0)
+			throw ocl_exception("Device does not support SPIR!");
 
-		if (!binaries_to_load_filename.empty()){
-			std::ifstream program_binaries_file;
-			program_binaries_file.open(binaries_to_load_filename);
+		std::string options = programOptions(*program_, *cl);
+		std::string cache_key = programCacheKey(binary, options, cl->deviceInfo());
 
-			std::string binaries_string((std::istreambuf_iterator<char>(program_binaries_file)), std::istreambuf_iterator<char>());
+		const std::vector<unsigned char>* cachedCompiledBinary = getCachedBinary(program_->id(), cl->platform(), cl->device());
 
-			loaded_from_file_binaries = std::vector<unsigned char>(binaries_string.size());
-			for (int i = 0; i < binaries_string.size(); ++i) {
-				loaded_from_file_binaries[i] = (unsigned char) binaries_string[i];
+		// other processes may be compiling the same program right now, waiting for them instead of compiling it again
+		std::unique_ptr<DiskCache::KeyLock> disk_cache_lock;
+		std::vector<unsigned char> disk_cached_binary;
+		bool from_disk_cache = false;
+		if (cachedCompiledBinary == NULL) {
+			disk_cache_lock.reset(new DiskCache::KeyLock(cache_key));
+			if (DiskCache::load(cache_key, disk_cached_binary)) {
+				cachedCompiledBinary = &disk_cached_binary;
+				from_disk_cache = true;
 			}
-			cachedCompiledBinary = &loaded_from_file_binaries;
-
-			program_binaries_file.close();
 		}
 
-		if (cachedCompiledBinary != NULL) {
-			std::vector<const unsigned char *>	kernel_ptrs;
-			std::vector<size_t>					kernel_sizes;
-
-			kernel_ptrs.push_back(cachedCompiledBinary->data());
-			kernel_sizes.push_back(cachedCompiledBinary->size());
-
-			cl_device_id device = cl->device();
-			cl_int binary_status;
-
-			program = clCreateProgramWithBinary(cl->context(), 1, &device, &kernel_sizes[0], &kernel_ptrs[0], &binary_status, &ciErrNum);
-			OCL_SAFE_CALL(binary_status);
-			OCL_SAFE_CALL(ciErrNum);
-		} else if (binary->deviceAddressBits() == 0) {
-			std::vector<const char *>			kernel_ptrs;
-			std::vector<size_t>					kernel_sizes;
-
-			kernel_ptrs.push_back(binary->data());
-			kernel_sizes.push_back(binary->size());
-
-			program = clCreateProgramWithSource(cl->context(), kernel_ptrs.size(), &kernel_ptrs[0], &kernel_sizes[0], &ciErrNum);
-			OCL_SAFE_CALL(ciErrNum);
-		} else {
-			std::vector<const unsigned char *>	kernel_ptrs;
-			std::vector<size_t>					kernel_sizes;
-
-			kernel_ptrs.push_back((unsigned char*) binary->data());
-			kernel_sizes.push_back(binary->size());
+		cl_int ciErrNum = CL_SUCCESS;
 
-			cl_device_id device = cl->device();
-			cl_int binary_status;
+		if (cachedCompiledBinary != NULL) {
+			program = createProgramWithBinary(cl, cachedCompiledBinary->data(), cachedCompiledBinary->size());
+			if (program) {
+				ciErrNum = clBuildProgram(program, 0, NULL, options.c_str(), NULL, NULL);
+				if (ciErrNum != CL_SUCCESS) {
+					clReleaseProgram(program);
+					program = 0;
+				}
+			}
 
-			program = clCreateProgramWithBinary(cl->context(), 1, &device, &kernel_sizes[0], &kernel_ptrs[0], &binary_status, &ciErrNum);
-			OCL_SAFE_CALL(binary_status);
-			OCL_SAFE_CALL(ciErrNum);
+			if (program) {
+				if (verbose)
+					ocl::oclPrintBuildLog(program);
+				if (from_disk_cache)
+					setCachedBinary(program_->id(), cl->platform(), cl->device(), disk_cached_binary);
+			} else if (from_disk_cache) {
+				// rejected by the driver (e.g. it was updated without changing its version string), rebuilding from sources
+				DiskCache::remove(cache_key);
+			}
+		}
 
-			if (cl->deviceInfo().extensions.count("cl_khr_spir") == 0)
-				throw ocl_exception("Device does not support SPIR!");
+		if (!program) {
+			std::string build_options = options;
 
-			options += " -x spir";
-		}
+			if (binary->deviceAddressBits() == 0) {
+				std::vector<const char *>			kernel_ptrs;
+				std::vector<size_t>					kernel_sizes;
 
-		options += " -D WARP_SIZE=" + to_string(cl->wavefrontSize());
+				kernel_ptrs.push_back(binary->data());
+				kernel_sizes.push_back(binary->size());
 
-		timer tm;
-		tm.start();
+				program = clCreateProgramWithSource(cl->context(), kernel_ptrs.size(), &kernel_ptrs[0], &kernel_sizes[0], &ciErrNum);
+				OCL_SAFE_CALL(ciErrNum);
+			} else {
+				program = createProgramWithBinary(cl, (const unsigned char *) binary->data(), binary->size(), true);
 
-		if (cachedCompiledBinary == NULL && verbose) {
-			if (program_->programName() == "") {
-				std::cout << "Building kernels for " << cl->deviceName() << "... " << std::endl;
+				build_options += " -x spir";
 			}
-//			else {
-//				std::cout << "Building kernel " << program_->programName() << " for " << cl->deviceName() << "... " << std::endl;
-//			}
-		}
 
-		ciErrNum = clBuildProgram(program, 0, NULL, options.c_str(), NULL, NULL);
+			timer tm;
+			tm.start();
 
-		if (ciErrNum == CL_SUCCESS && cachedCompiledBinary == NULL) {
-			if (program_->programName() == "" && verbose) {
-				std::cout << "Kernels compilation done in " << tm.elapsed() << " seconds" << std::endl;
+			if (verbose && program_->programName() == "") {
+				std::cout << "Building kernels for " << cl->deviceName() << "... " << std::endl;
 			}
-//			else {
-//				std::cout << "Kernel " << program_->programName() << " compilation done in " << tm.elapsed() << " seconds" << std::endl;
-//			}
 
-			std::vector<unsigned char> binaries = getProgramBinaries(program);
-			setCachedBinary(program_->id(), cl->platform(), cl->device(), binaries);
-		}
+			ciErrNum = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
 
-		if (ciErrNum != CL_SUCCESS || verbose) {
-			ocl::oclPrintBuildLog(program);
+			if (ciErrNum == CL_SUCCESS) {
+				if (program_->programName() == "" && verbose) {
+					std::cout << "Kernels compilation done in " << tm.elapsed() << " seconds" << std::endl;
+				}
 
-			std::string binaries_filename = DUMP_KERNEL_BINARIES_TO_FILE;
-			if (!binaries_filename.empty()) {
 				std::vector<unsigned char> binaries = getProgramBinaries(program);
-				std::string binaries_string((char*) binaries.data(), binaries.size());
+				setCachedBinary(program_->id(), cl->platform(), cl->device(), binaries);
+				DiskCache::store(cache_key, binaries);
+			}
 
-				std::ofstream program_binaries_file;
-				program_binaries_file.open(binaries_filename + "_platform" + to_string(cl->platform()) + "_device" + to_string(cl->device()) + "_program" + to_string(program_->id()));
+			if (ciErrNum != CL_SUCCESS || verbose) {
+				ocl::oclPrintBuildLog(program);
+			}
 
-				program_binaries_file << binaries_string;
-				program_binaries_file.close();
+			if (ciErrNum != CL_SUCCESS) {
+				clReleaseProgram(program);
+				program = 0;
 			}
-		}
 
-		if (ciErrNum != CL_SUCCESS) {
-			clReleaseProgram(program);
-			program = 0;
+			OCL_SAFE_CALL(ciErrNum);
 		}
 
-		OCL_SAFE_CALL(ciErrNum);
-		cl->programs()[program_->id()] = program;
+		cl->addProgram(program_->id(), program);
 	}
 
 	kernel = new OpenCLKernel;
-	kernel->create(program, name_.c_str());
+	try {
+		kernel->create(program, name_.c_str(), cl->device());
+	} catch (...) {
+		delete kernel;
+		throw;
+	}
 
-	cl->kernels()[id_] = kernel;
+	cl->addKernel(id_, kernel);
 
 	return kernel;
 }
 
-void KernelSource::exec(const gpu::WorkSize &ws, const Arg &arg0, const Arg &arg1, const Arg &arg2, const Arg &arg3, const Arg &arg4, const Arg &arg5, const Arg &arg6, const Arg &arg7, const Arg &arg8, const Arg &arg9, const Arg &arg10, const Arg &arg11, const Arg &arg12, const Arg &arg13, const Arg &arg14, const Arg &arg15, const Arg &arg16, const Arg &arg17, const Arg &arg18, const Arg &arg19, const Arg &arg20, const Arg &arg21, const Arg &arg22, const Arg &arg23, const Arg &arg24, const Arg &arg25, const Arg &arg26, const Arg &arg27, const Arg &arg28, const Arg &arg29, const Arg &arg30, const Arg &arg31, const Arg &arg32, const Arg &arg33, const Arg &arg34, const Arg &arg35, const Arg &arg36, const Arg &arg37, const Arg &arg38, const Arg &arg39, const Arg &arg40)
+void KernelSource::execArray(const gpu::WorkSize &ws, const Arg *args, size_t nargs)
 {
 	gpu::Context context;
+	sh_ptr_ocl_engine cl = context.cl();
 
-	OpenCLKernel *kernel = getKernel(context.cl());
+	OpenCLKernel *kernel = getKernel(cl);
 
-	kernel->setArgs(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13, arg14, arg15, arg16, arg17, arg18, arg19, arg20, arg21, arg22, arg23, arg24, arg25, arg26, arg27, arg28, arg29, arg30, arg31, arg32, arg33, arg34, arg35, arg36, arg37, arg38, arg39, arg40);
+	OpenCLEvent event;
+	{
+		Lock lock(kernel->launchMutex());
+
+		kernel->setArgArray(args, nargs);
+
+		event = cl->ndRangeKernelUntracked(*kernel, 3, NULL, ws.clGlobalSize(), ws.clLocalSize());
+	}
 
-	context.cl()->ndRangeKernel(*kernel, 3, NULL, ws.clGlobalSize(), ws.clLocalSize());
+	// the kernel is not locked while waiting, so that other threads can launch it meanwhile
+	cl->waitUntracked(event, kernel->kernelName());
 }
 
-void KernelSource::execSubdivided(const gpu::WorkSize &ws, const Arg &arg0, const Arg &arg1, const Arg &arg2, const Arg &arg3, const Arg &arg4, const Arg &arg5, const Arg &arg6, const Arg &arg7, const Arg &arg8, const Arg &arg9, const Arg &arg10, const Arg &arg11, const Arg &arg12, const Arg &arg13, const Arg &arg14, const Arg &arg15, const Arg &arg16, const Arg &arg17, const Arg &arg18, const Arg &arg19, const Arg &arg20, const Arg &arg21, const Arg &arg22, const Arg &arg23, const Arg &arg24, const Arg &arg25, const Arg &arg26, const Arg &arg27, const Arg &arg28, const Arg &arg29, const Arg &arg30, const Arg &arg31, const Arg &arg32, const Arg &arg33, const Arg &arg34, const Arg &arg35, const Arg &arg36, const Arg &arg37, const Arg &arg38, const Arg &arg39, const Arg &arg40)
+OpenCLEvent KernelSource::execAsyncArray(const OpenCLStream &stream, const gpu::WorkSize &ws, const Arg *args, size_t nargs)
 {
-	const size_t max_total_size = 1000000;
+	gpu::Context context;
+	sh_ptr_ocl_engine cl = context.cl();
+
+	OpenCLKernel *kernel = getKernel(cl);
+
+	Lock lock(kernel->launchMutex());
+
+	kernel->setArgArray(args, nargs);
+
+	return cl->ndRangeKernelAsync(*kernel, 3, NULL, ws.clGlobalSize(), ws.clLocalSize(), stream);
+}
+
+namespace {
+	std::atomic<double>	subdivision_latency(0.05);
+}
+
+void KernelSource::setSubdivisionLatency(double seconds)
+{
+	subdivision_latency.store(seconds);
+}
+
+double KernelSource::subdivisionLatency()
+{
+	return subdivision_latency.load();
+}
+
+std::string KernelSource::tuningKey(const std::string &prefix, const std::shared_ptr<OpenCLEngine> &cl) const
+{
+	unsigned long long hash = programHash(program_->getBinary(cl), programOptions(*program_, *cl), cl->deviceInfo());
+	hash = DiskCache::hash(name_.data(), name_.size(), hash);
+	return prefix + "_" + DiskCache::hashString(hash) + ".txt";
+}
+
+void KernelSource::execSubdividedArray(const gpu::WorkSize &ws, const Arg *args, size_t nargs)
+{
+	// until the kernel throughput is measured
+	const size_t default_part_size = 1000000;
+
+	gpu::Context context;
+	sh_ptr_ocl_engine cl = context.cl();
+
+	OpenCLKernel *kernel = getKernel(cl);
+	OpenCLKernel::Subdivision &subdivision = kernel->subdivision();
 
 	const size_t local_x = ws.clLocalSize()[0];
 	const size_t local_y = ws.clLocalSize()[1];
@@ -660,6 +1164,22 @@ void KernelSource::execSubdivided(const gpu::WorkSize &ws, const Arg &arg0, cons
 	const size_t total_y = ws.clGlobalSize()[1];
 	const size_t total_z = ws.clGlobalSize()[2];
 
+	size_t max_total_size = 0;
+	{
+		Lock lock(kernel->launchMutex());
+
+		if (!subdivision.loaded) {
+			std::vector<unsigned char> data;
+			if (DiskCache::load(tuningKey("subdivision", cl), data)) {
+				subdivision.part_size			= atoll(std::string(data.begin(), data.end()).c_str());
+				subdivision.stored_part_size	= subdivision.part_size;
+			}
+			subdivision.loaded = true;
+		}
+
+		max_total_size = subdivision.part_size ? subdivision.part_size : default_part_size;
+	}
+
 	size_t nparts_x = 1;
 	size_t nparts_y = 1;
 	size_t nparts_z = 1;
@@ -681,31 +1201,220 @@ void KernelSource::execSubdivided(const gpu::WorkSize &ws, const Arg &arg0, cons
 		part_z = local_z * gpu::divup(gpu::divup(total_z, nparts_z), local_z);
 	}
 
+	timer tm;
+	std::vector<OpenCLEvent> events;
+	{
+		Lock lock(kernel->launchMutex());
+
+		kernel->setArgArray(args, nargs);
+
+		for (size_t offset_x = 0; offset_x < total_x; offset_x += part_x) {
+			for (size_t offset_y = 0; offset_y < total_y; offset_y += part_y) {
+				for (size_t offset_z = 0; offset_z < total_z; offset_z += part_z) {
+					size_t offset[3];
+					offset[0] = offset_x;
+					offset[1] = offset_y;
+					offset[2] = offset_z;
+
+					size_t current_x = std::min(part_x, total_x - offset_x);
+					size_t current_y = std::min(part_y, total_y - offset_y);
+					size_t current_z = std::min(part_z, total_z - offset_z);
+
+					gpu::WorkSize ws_part(local_x, local_y, local_z, current_x, current_y, current_z);
+
+					// NOTTODO: generalize this logic, apply it to CUDA, make so that ndRangeKernel is called only in one place in codebase, remove all get_group_id/get_num_groups calls, etc.
+					events.push_back(cl->ndRangeKernelUntracked(*kernel, 3, offset, ws_part.clGlobalSize(), ws_part.clLocalSize()));
+				}
+			}
+		}
+	}
+
+	// the queue is in-order, so the last part is finished after all others, but errors are reported by their own events.
+	// All parts are waited for before the first error is thrown
+	std::string error;
+	for (size_t i = 0; i < events.size(); ++i) {
+		try {
+			cl->waitUntracked(events[i], kernel->kernelName());
+		} catch (const std::exception &e) {
+			if (error.empty())
+				error = e.what();
+		}
+	}
+	if (!error.empty())
+		throw ocl_exception(error);
+
+	// parts run back-to-back, so the elapsed time (including commands enqueued before, which only makes parts smaller) is the sum of their latencies
+	double elapsed = tm.elapsed();
+	double items = (double) total_x * total_y * total_z;
+	// a launch smaller than a part tells nothing about bigger parts, its time is mostly the launch overhead
+	if (elapsed <= 0.0 || items < max_total_size)
+		return;
+
+	// moving at most 4x per call, so that a single noisy measurement does not break it
+	double part_size = items / elapsed * subdivisionLatency();
+	part_size = std::max(part_size, (double) max_total_size / 4);
+	part_size = std::min(part_size, (double) max_total_size * 4);
+	part_size = std::max(part_size, (double) local_x * local_y * local_z);
+
+	Lock lock(kernel->launchMutex());
+
+	subdivision.part_size = (size_t) part_size;
+
+	// persisting only noticeable changes
+	size_t stored = subdivision.stored_part_size;
+	if (stored == 0 || subdivision.part_size > stored + stored / 4 || subdivision.part_size < stored - stored / 4) {
+		std::string value = to_string(subdivision.part_size);
+		DiskCache::store(tuningKey("subdivision", cl), std::vector<unsigned char>(value.begin(), value.end()));
+		subdivision.stored_part_size = subdivision.part_size;
+	}
+}
+
+namespace {
+	gpu::WorkSize makeWorkSize(int work_dim, const size_t *local, const size_t *global)
+	{
+		if (work_dim == 1)
+			return gpu::WorkSize((unsigned int) local[0], (unsigned int) global[0]);
+		if (work_dim == 2)
+			return gpu::WorkSize((unsigned int) local[0], (unsigned int) local[1], (unsigned int) global[0], (unsigned int) global[1]);
+		return gpu::WorkSize((unsigned int) local[0], (unsigned int) local[1], (unsigned int) local[2],
+							 (unsigned int) global[0], (unsigned int) global[1], (unsigned int) global[2]);
+	}
+}
+
+void KernelSource::execTunedArray(const gpu::WorkSize &ws, const Arg *args, size_t nargs)
+{
 	gpu::Context context;
+	sh_ptr_ocl_engine cl = context.cl();
+
+	OpenCLKernel *kernel = getKernel(cl);
 
-	OpenCLKernel *kernel = getKernel(context.cl());
+	int work_dim = ws.clWorkDim();
 
-	kernel->setArgs(arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13, arg14, arg15, arg16, arg17, arg18, arg19, arg20, arg21, arg22, arg23, arg24, arg25, arg26, arg27, arg28, arg29, arg30, arg31, arg32, arg33, arg34, arg35, arg36, arg37, arg38, arg39, arg40);
+	OpenCLEvent event;
+	{
+		// concurrent callers wait for the tuning instead of tuning again
+		Lock lock(kernel->launchMutex());
+
+		kernel->setArgArray(args, nargs);
+
+		OpenCLKernel::Tuning &tuning = kernel->tuning(work_dim);
+		if (!tuning.loaded) {
+			std::vector<unsigned char> data;
+			if (DiskCache::load(tuningKey("workgroup" + to_string(work_dim) + "d", cl), data)) {
+				std::istringstream stream(std::string(data.begin(), data.end()));
+				size_t local_size[3] = {1, 1, 1};
+				for (int d = 0; d < work_dim; ++d)
+					stream >> local_size[d];
+
+				if (stream && local_size[0] * local_size[1] * local_size[2] <= kernel->workGroupSize()) {
+					for (int d = 0; d < 3; ++d)
+						tuning.local_size[d] = local_size[d];
+				}
+			}
+			tuning.loaded = true;
+		}
 
-	for (size_t offset_x = 0; offset_x < total_x; offset_x += part_x) {
-		for (size_t offset_y = 0; offset_y < total_y; offset_y += part_y) {
-			for (size_t offset_z = 0; offset_z < total_z; offset_z += part_z) {
-				size_t offset[3];
-				offset[0] = offset_x;
-				offset[1] = offset_y;
-				offset[2] = offset_z;
+		if (!tuning.local_size[0])
+			tuneWorkSize(cl, *kernel, ws);
 
-				size_t current_x = std::min(part_x, total_x - offset_x);
-				size_t current_y = std::min(part_y, total_y - offset_y);
-				size_t current_z = std::min(part_z, total_z - offset_z);
+		gpu::WorkSize tuned = makeWorkSize(work_dim, tuning.local_size, ws.clGlobalSize());
+		event = cl->ndRangeKernelUntracked(*kernel, 3, NULL, tuned.clGlobalSize(), tuned.clLocalSize());
+	}
+
+	cl->waitUntracked(event, kernel->kernelName());
+}
+
+void KernelSource::tuneWorkSize(const std::shared_ptr<OpenCLEngine> &cl, OpenCLKernel &kernel, const gpu::WorkSize &ws)
+{
+	int work_dim = ws.clWorkDim();
+	const size_t *global = ws.clGlobalSize();
+
+	size_t max_size = kernel.workGroupSize();
+	size_t multiple = kernel.preferredWorkGroupSizeMultiple();
+
+	// powers of two along every dimension, the total size is a multiple of the preferred one if possible
+	std::vector<std::vector<size_t> > candidates;
+	candidates.push_back(std::vector<size_t>(ws.clLocalSize(), ws.clLocalSize() + 3));
+
+	size_t limits[3] = {1, 1, 1};
+	for (int d = 0; d < work_dim; ++d) {
+		limits[d] = std::min(cl->maxWorkItemSizes(d), max_size);
+		// more than half of the work items of such group would be idle
+		while (limits[d] > 1 && limits[d] >= 2 * global[d])
+			limits[d] /= 2;
+	}
 
-				gpu::WorkSize ws_part(local_x, local_y, local_z, current_x, current_y, current_z);
+	bool multiple_reachable = multiple <= max_size && multiple <= limits[0] * limits[1] * limits[2];
+
+	for (size_t x = 1; x <= limits[0]; x *= 2) {
+		for (size_t y = 1; y <= limits[1]; y *= 2) {
+			for (size_t z = 1; z <= limits[2]; z *= 2) {
+				size_t size = x * y * z;
+				if (size > max_size || (multiple_reachable && size % multiple != 0))
+					continue;
+
+				std::vector<size_t> candidate(3);
+				candidate[0] = x;
+				candidate[1] = y;
+				candidate[2] = z;
+				if (candidate != candidates[0])
+					candidates.push_back(candidate);
+			}
+		}
+	}
 
-				// NOTTODO: generalize this logic, apply it to CUDA, make so that ndRangeKernel is called only in one place in codebase, remove all get_group_id/get_num_groups calls, etc.
-				context.cl()->ndRangeKernel(*kernel, 3, offset, ws_part.clGlobalSize(), ws_part.clLocalSize());
+	double best_time = 0.0;
+	size_t best = candidates.size();
+	for (size_t i = 0; i < candidates.size(); ++i) {
+		gpu::WorkSize candidate = makeWorkSize(work_dim, candidates[i].data(), global);
+
+		// the first launch is a warm-up, then the best of several launches is taken.
+		// Events are untracked, so the error of a skipped candidate doesn't resurface at the next finish()
+		double time = 0.0;
+		try {
+			for (int run = 0; run < 3; ++run) {
+				timer tm;
+				cl->ndRangeKernelUntracked(kernel, 3, NULL, candidate.clGlobalSize(), candidate.clLocalSize()).wait();
+				double elapsed = tm.elapsed();
+				if (run == 1 || (run > 1 && elapsed < time))
+					time = elapsed;
 			}
+		} catch (const std::exception &) {
+			// e.g. not enough local memory for such group
+			continue;
+		}
+
+		if (best == candidates.size() || time < best_time) {
+			best_time	= time;
+			best		= i;
 		}
 	}
+
+	if (best == candidates.size())
+		throw ocl_exception("No work group size of kernel " + name_ + " can be launched!");
+
+	OpenCLKernel::Tuning &tuning = kernel.tuning(work_dim);
+	for (int d = 0; d < 3; ++d)
+		tuning.local_size[d] = d < work_dim ? candidates[best][d] : 1;
+
+	std::string value;
+	for (int d = 0; d < work_dim; ++d)
+		value += (d ? " " : "") + to_string(tuning.local_size[d]);
+	DiskCache::store(tuningKey("workgroup" + to_string(work_dim) + "d", cl), std::vector<unsigned char>(value.begin(), value.end()));
+}
+
+void KernelSource::enqueueArray(const OpenCLStream &stream, const gpu::WorkSize &ws, const Arg *args, size_t nargs)
+{
+	gpu::Context context;
+	sh_ptr_ocl_engine cl = context.cl();
+
+	OpenCLKernel *kernel = getKernel(cl);
+
+	Lock lock(kernel->launchMutex());
+
+	kernel->setArgArray(args, nargs);
+
+	cl->enqueueNDRangeKernel(*kernel, 3, NULL, ws.clGlobalSize(), ws.clLocalSize(), stream);
 }
 
 void KernelSource::precompile(bool printLog) {
@@ -722,11 +1431,8 @@ OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer &arg)
 {
 	is_null = false;
 	size = sizeof(cl_mem);
-	cl_mem_storage = arg.clmem();
+	cl_mem_storage = arg.clmemView();
 	value = &cl_mem_storage;
-	if (arg.cloffset() != 0) {
-		ocl_exception("Offset is not zero, but ignored!");
-	}
 }
 
 template<typename T>
@@ -734,11 +1440,32 @@ OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<T> &arg)
 {
 	is_null = false;
 	size = sizeof(cl_mem);
-	cl_mem_storage = arg.clmem();
+	cl_mem_storage = arg.clmemView();
 	value = &cl_mem_storage;
-	if (arg.cloffset() != 0) {
-		ocl_exception("Offset is not zero, but ignored!");
-	}
+}
+
+OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer &arg)
+{
+	*this = arg.isSVM() ? svmPointer(arg.svmptr()) : OpenCLKernelArg(arg.buffer());
+}
+
+template<typename T>
+OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<T> &arg)
+{
+	*this = arg.isSVM() ? svmPointer(arg.svmptr()) : OpenCLKernelArg(arg.buffer());
+}
+
+OffsetView::OffsetView(const gpu::shared_device_buffer &buffer, size_t element_size)
+{
+	if (buffer.cloffset() % element_size != 0)
+		throw ocl_exception("Offset " + to_string(buffer.cloffset()) + " is not a multiple of element size " + to_string(element_size) + "!");
+
+	size_t elements = buffer.cloffset() / element_size;
+	if (elements > std::numeric_limits<unsigned int>::max())
+		throw ocl_exception("Offset of " + to_string(elements) + " elements doesn't fit into the unsigned int offset parameter!");
+
+	mem		= buffer.clmem();
+	offset	= (cl_uint) elements;
 }
 
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<char> &arg);
@@ -749,3 +1476,12 @@ template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<unsigned int> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<float> &arg);
 template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_device_buffer_typed<double> &arg);
+
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<char> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<unsigned char> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<short> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<unsigned short> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<int> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<unsigned int> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<float> &arg);
+template OpenCLKernelArg::OpenCLKernelArg(const gpu::shared_svm_buffer_typed<double> &arg);
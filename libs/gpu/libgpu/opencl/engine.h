@@ -10,17 +10,26 @@
 #include <CL/cl.h>
 #include <libgpu/work_size.h>
 #include <libgpu/opencl/device_info.h>
+#include <libgpu/opencl/buffer_pool.h>
+#include <libgpu/opencl/event.h>
+#include <libgpu/opencl/id_table.h>
+#include <libgpu/opencl/profiler.h>
 #include <libgpu/opencl/utils.h>
 #include <libgpu/utils.h>
+#include <libutils/thread_mutex.h>
 #include <memory>
 #include <map>
 
 namespace gpu {
 	class WorkSize;
 	class shared_device_buffer;
+	class shared_svm_buffer;
 
 	template <typename T>
 	class shared_device_buffer_typed;
+
+	template <typename T>
+	class shared_svm_buffer_typed;
 }
 
 namespace ocl {
@@ -50,25 +59,132 @@ namespace ocl {
 
 	class OpenCLKernelArg {
 	public:
-		OpenCLKernelArg() : is_null(true), size(0), value(0), cl_mem_storage(NULL) { }
+		OpenCLKernelArg() : is_null(true), is_svm(false), size(0), value(0), cl_mem_storage(NULL) { }
 
 		template <typename T>
-		OpenCLKernelArg(const T &arg) : is_null(false), size(sizeof(arg)), value(&arg), cl_mem_storage(NULL) { }
+		OpenCLKernelArg(const T &arg) : is_null(false), is_svm(false), size(sizeof(arg)), value(&arg), cl_mem_storage(NULL) { }
+
+		OpenCLKernelArg(const LocalMem &arg) : is_null(false), is_svm(false), size(arg.size), value(0), cl_mem_storage(NULL) { }
 
-		OpenCLKernelArg(const LocalMem &arg) : is_null(false), size(arg.size), value(0), cl_mem_storage(NULL) { }
+		// value may point to own cl_mem_storage
+		OpenCLKernelArg(const OpenCLKernelArg &other) : is_null(other.is_null), is_svm(other.is_svm), size(other.size), value(other.value), cl_mem_storage(other.cl_mem_storage)
+		{
+			if (other.value == &other.cl_mem_storage)
+				value = &cl_mem_storage;
+		}
 
+		OpenCLKernelArg &operator= (const OpenCLKernelArg &other)
+		{
+			is_null			= other.is_null;
+			is_svm			= other.is_svm;
+			size			= other.size;
+			cl_mem_storage	= other.cl_mem_storage;
+			value			= other.value == &other.cl_mem_storage ? &cl_mem_storage : other.value;
+			return *this;
+		}
+
+		// Buffers with non-zero offset are passed as cached sub-buffers, the offset must be aligned to CL_DEVICE_MEM_BASE_ADDR_ALIGN
 		OpenCLKernelArg(const gpu::shared_device_buffer &arg);
 
 		template <typename T>
 		OpenCLKernelArg(const gpu::shared_device_buffer_typed<T> &arg);
 
+		// SVM pointer (clSetKernelArgSVMPointer) or the fallback buffer
+		OpenCLKernelArg(const gpu::shared_svm_buffer &arg);
+
+		template <typename T>
+		OpenCLKernelArg(const gpu::shared_svm_buffer_typed<T> &arg);
+
+		static OpenCLKernelArg	memObject(cl_mem mem)
+		{
+			OpenCLKernelArg res;
+			res.is_null			= false;
+			res.size			= sizeof(cl_mem);
+			res.cl_mem_storage	= mem;
+			res.value			= &res.cl_mem_storage;
+			return res;
+		}
+
+		// value is the pointer itself, kept in cl_mem_storage
+		static OpenCLKernelArg	svmPointer(const void *ptr)
+		{
+			OpenCLKernelArg res = memObject((cl_mem) ptr);
+			res.is_svm			= true;
+			return res;
+		}
+
+		bool			isMemObject() const		{ return value == &cl_mem_storage && !is_svm;	}
+		const void *	svmPointer() const		{ return is_svm ? (const void *) cl_mem_storage : 0;	}
+
 		bool			is_null;
+		bool			is_svm;
 		size_t			size;
 		const void *	value;
 	protected:
 		cl_mem 			cl_mem_storage;
 	};
 
+	// View of a buffer with any offset for a kernel that takes (__global T *base, unsigned int offset) in place of one pointer:
+	// passes the whole buffer and the offset of the view in elements (throws if it doesn't fit into unsigned int).
+	// Views with aligned offsets can be passed as is.
+	class OffsetView {
+	public:
+		OffsetView(const gpu::shared_device_buffer &buffer, size_t element_size = 1);
+
+		template <typename T>
+		OffsetView(const gpu::shared_device_buffer_typed<T> &buffer) : OffsetView(buffer, sizeof(T)) { }
+
+		cl_mem			mem;
+		cl_uint			offset;
+	};
+
+	template <typename T>
+	struct OpenCLKernelArgCount					{ static const size_t value = 1; };
+
+	template <>
+	struct OpenCLKernelArgCount<OffsetView>		{ static const size_t value = 2; };
+
+	template <typename... Args>
+	struct OpenCLKernelArgsCount				{ static const size_t value = 0; };
+
+	template <typename T, typename... Rest>
+	struct OpenCLKernelArgsCount<T, Rest...>	{ static const size_t value = OpenCLKernelArgCount<T>::value + OpenCLKernelArgsCount<Rest...>::value; };
+
+	// Arguments of a variadic launch, must not outlive the full expression of the call
+	template <typename... Args>
+	class OpenCLKernelArgs {
+	public:
+		OpenCLKernelArgs(const Args &... args) : size_(0)	{ append(args...);	}
+
+		const OpenCLKernelArg *		data() const			{ return list_;		}
+		size_t						size() const			{ return size_;		}
+
+	protected:
+		void append() { }
+
+		template <typename T, typename... Rest>
+		void append(const T &arg, const Rest &... rest)
+		{
+			add(arg);
+			append(rest...);
+		}
+
+		template <typename T>
+		void add(const T &arg)
+		{
+			list_[size_++] = OpenCLKernelArg(arg);
+		}
+
+		void add(const OffsetView &view)
+		{
+			list_[size_++] = OpenCLKernelArg::memObject(view.mem);
+			list_[size_++] = OpenCLKernelArg(view.offset);
+		}
+
+		OpenCLKernelArg		list_[OpenCLKernelArgsCount<Args...>::value + 1];
+		size_t				size_;
+	};
+
 	class OpenCLKernel {
 	public:
 		OpenCLKernel();
@@ -79,66 +195,79 @@ namespace ocl {
 		cl_kernel	kernel(void)			{ return kernel_;			}
 		std::string kernelName(void)		{ return kernel_name_;		}
 		size_t		workGroupSize(void)		{ return work_group_size_;	}
+		// Local sizes should be its multiples for performance (1 on OpenCL 1.0)
+		size_t		preferredWorkGroupSizeMultiple(void)	{ return preferred_work_group_size_multiple_;	}
 
 		typedef OpenCLKernelArg Arg;
 
-		void setArgs(const Arg &arg0 = Arg(), const Arg &arg1 = Arg(), const Arg &arg2 = Arg(), const Arg &arg3 = Arg(), const Arg &arg4 = Arg(), const Arg &arg5 = Arg(), const Arg &arg6 = Arg(), const Arg &arg7 = Arg(), const Arg &arg8 = Arg(), const Arg &arg9 = Arg(), const Arg &arg10 = Arg(), const Arg &arg11 = Arg(), const Arg &arg12 = Arg(), const Arg &arg13 = Arg(), const Arg &arg14 = Arg(), const Arg &arg15 = Arg(), const Arg &arg16 = Arg(), const Arg &arg17 = Arg(), const Arg &arg18 = Arg(), const Arg &arg19 = Arg(), const Arg &arg20 = Arg(), const Arg &arg21 = Arg(), const Arg &arg22 = Arg(), const Arg &arg23 = Arg(), const Arg &arg24 = Arg(), const Arg &arg25 = Arg(), const Arg &arg26 = Arg(), const Arg &arg27 = Arg(), const Arg &arg28 = Arg(), const Arg &arg29 = Arg(), const Arg &arg30 = Arg(), const Arg &arg31 = Arg(), const Arg &arg32 = Arg(), const Arg &arg33 = Arg(), const Arg &arg34 = Arg(), const Arg &arg35 = Arg(), const Arg &arg36 = Arg(), const Arg &arg37 = Arg(), const Arg &arg38 = Arg(), const Arg &arg39 = Arg(), const Arg &arg40 = Arg())
+		template <typename... Args>
+		void setArgs(const Args &... args)
 		{
-			setArg( 0, arg0);
-			setArg( 1, arg1);
-			setArg( 2, arg2);
-			setArg( 3, arg3);
-			setArg( 4, arg4);
-			setArg( 5, arg5);
-			setArg( 6, arg6);
-			setArg( 7, arg7);
-			setArg( 8, arg8);
-			setArg( 9, arg9);
-			setArg(10, arg10);
-			setArg(11, arg11);
-			setArg(12, arg12);
-			setArg(13, arg13);
-			setArg(14, arg14);
-			setArg(15, arg15);
-			setArg(16, arg16);
-			setArg(17, arg17);
-			setArg(18, arg18);
-			setArg(19, arg19);
-			setArg(20, arg20);
-			setArg(21, arg21);
-			setArg(22, arg22);
-			setArg(23, arg23);
-			setArg(24, arg24);
-			setArg(25, arg25);
-			setArg(26, arg26);
-			setArg(27, arg27);
-			setArg(28, arg28);
-			setArg(29, arg29);
-			setArg(30, arg30);
-			setArg(31, arg31);
-			setArg(32, arg32);
-			setArg(33, arg33);
-			setArg(34, arg34);
-			setArg(35, arg35);
-			setArg(36, arg36);
-			setArg(37, arg37);
-			setArg(38, arg38);
-			setArg(39, arg39);
-			setArg(40, arg40);
+			OpenCLKernelArgs<Args...> list(args...);
+			setArgArray(list.data(), list.size());
 		}
 
-	protected:
-		void		setArg(cl_uint arg_index, size_t arg_size, const void *arg_value);
+		// Arguments equal to the ones bound by the previous launch are not passed to clSetKernelArg again
+		void setArgArray(const Arg *args, size_t nargs);
 
-		void		setArg(cl_uint arg_index, const Arg &arg)
-		{
-			if (!arg.is_null)
-				setArg(arg_index, arg.size, arg.value);
-		}
+		// Number of clSetKernelArg calls made and skipped because the argument did not change
+		size_t		argsBound() const		{ return args_bound_;		}
+		size_t		argsSkipped() const		{ return args_skipped_;		}
+
+		// Must be called whenever a cl_mem is released: a new buffer can get the same handle
+		static void	invalidateMemArgs();
+
+		// Held from setting arguments till the kernel is enqueued, so that the kernel can be launched from several threads
+		Mutex &		launchMutex()			{ return launch_mutex_;		}
+
+		// Part size of KernelSource::execSubdivided() tuned for its target latency, guarded by launchMutex()
+		struct Subdivision {
+			Subdivision() : loaded(false), part_size(0), stored_part_size(0) { }
 
-		cl_kernel	kernel_;
-		size_t		work_group_size_;
-		std::string	kernel_name_;
+			bool		loaded;				// from the disk cache
+			size_t		part_size;			// in work items, 0 until known
+			size_t		stored_part_size;	// in the disk cache
+		};
+
+		Subdivision &	subdivision()		{ return subdivision_;		}
+
+		// Local sizes of KernelSource::execTuned() for 1D, 2D and 3D launches, guarded by launchMutex()
+		struct Tuning {
+			Tuning() : loaded(false) { local_size[0] = local_size[1] = local_size[2] = 0; }
+
+			bool		loaded;				// from the disk cache
+			size_t		local_size[3];		// zeros until known
+		};
+
+		Tuning &		tuning(int work_dim)	{ return tuning_[work_dim - 1];	}
+
+	protected:
+		void		setArg(cl_uint arg_index, size_t arg_size, const void *arg_value);
+		void		setArg(cl_uint arg_index, const Arg &arg, unsigned int mem_generation);
+
+		struct BoundArg {
+			BoundArg() : valid(false), is_mem(false), is_svm(false), mem_generation(0), size(0) { }
+
+			bool						valid;
+			bool						is_mem;
+			bool						is_svm;
+			unsigned int				mem_generation;
+			size_t						size;
+			std::vector<unsigned char>	value;		// empty for local memory
+		};
+
+		cl_kernel				kernel_;
+		size_t					work_group_size_;
+		size_t					preferred_work_group_size_multiple_;
+		std::string				kernel_name_;
+
+		std::vector<BoundArg>	bound_args_;
+		size_t					args_bound_;
+		size_t					args_skipped_;
+
+		Mutex					launch_mutex_;
+		Subdivision				subdivision_;
+		Tuning					tuning_[3];
 	};
 
 	class OpenCLEngine {
@@ -149,6 +278,8 @@ namespace ocl {
 		void				init(cl_device_id device_id = 0, const char *cl_params = 0, bool verbose = false);
 		void				init(cl_platform_id platform_id = 0, cl_device_id device_id = 0, const char *cl_params = 0, bool verbose = false);
 		cl_mem				createBuffer(cl_mem_flags flags, size_t size);
+		// Cached allocations for gpu::shared_device_buffer, release them with bufferPool()->release()
+		const std::shared_ptr<BufferPool> &	bufferPool() const	{ return buffer_pool_;	}
 		void				writeBuffer(cl_mem buffer, cl_bool blocking_write, size_t offset, size_t cb, const void *ptr);
 		void				writeBufferRect(cl_mem buffer, cl_bool blocking_write, const size_t buffer_origin[3], const size_t host_origin[3], const size_t region[3],
 								size_t buffer_row_pitch, size_t buffer_slice_pitch, size_t host_row_pitch, size_t host_slice_pitch, const void *ptr);
@@ -156,16 +287,65 @@ namespace ocl {
 		void				readBufferRect(cl_mem buffer, cl_bool blocking_write, const size_t buffer_origin[3], const size_t host_origin[3], const size_t region[3],
 											size_t buffer_row_pitch, size_t buffer_slice_pitch, size_t host_row_pitch, size_t host_slice_pitch, void *ptr);
 		void				copyBuffer(cl_mem src_buffer, cl_mem dst_buffer, size_t src_offset, size_t dst_offset, size_t cb);
+		// Blocking map, the region stays mapped until unmapBuffer()
+		void *				mapBuffer(cl_mem buffer, cl_map_flags flags, size_t offset, size_t cb);
+		// Waits for the unmap, so the buffer can be released right after
+		void				unmapBuffer(cl_mem buffer, void *ptr);
+		// OpenCL 2.0 shared virtual memory, svmAlloc() returns 0 if it is not supported. svmFree() waits for all queues
+		void *				svmAlloc(cl_bitfield flags, size_t size);
+		void				svmFree(void *ptr);
+		// For coarse-grained SVM, the same semantics as mapBuffer()/unmapBuffer()
+		void				svmMap(void *ptr, cl_map_flags flags, size_t size);
+		void				svmUnmap(void *ptr);
 		void				ndRangeKernel(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
 											const size_t *global_work_size, const size_t *local_work_size);
 		void				releaseMemObject(cl_mem memobj);
 
+		// Non-blocking versions: command is only enqueued, its execution errors are reported
+		// by OpenCLEvent::wait() or by finish(). Host memory must stay valid until the command is finished.
+		OpenCLEvent			writeBufferAsync(cl_mem buffer, size_t offset, size_t cb, const void *ptr, const OpenCLStream &stream = OpenCLStream());
+		OpenCLEvent			readBufferAsync(cl_mem buffer, size_t offset, size_t cb, void *ptr, const OpenCLStream &stream = OpenCLStream());
+		OpenCLEvent			copyBufferAsync(cl_mem src_buffer, cl_mem dst_buffer, size_t src_offset, size_t dst_offset, size_t cb, const OpenCLStream &stream = OpenCLStream());
+		OpenCLEvent			ndRangeKernelAsync(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
+												const size_t *global_work_size, const size_t *local_work_size, const OpenCLStream &stream = OpenCLStream());
+
+		// For launches that are waited on right away: the event is not kept for finish(), so its execution error
+		// is reported only once, by waitUntracked()
+		OpenCLEvent			ndRangeKernelUntracked(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
+													const size_t *global_work_size, const size_t *local_work_size, const OpenCLStream &stream = OpenCLStream());
+		void				waitUntracked(const OpenCLEvent &event, const std::string &name, size_t bytes = 0);
+
+		// Enqueued without events unless profiling is enabled, so that a long sequence of commands costs no event tracking
+		// (see gpu::Batch). Their execution errors are not reported, unless profiling is enabled (then finish() throws them).
+		void				enqueueWriteBuffer(cl_mem buffer, size_t offset, size_t cb, const void *ptr, const OpenCLStream &stream = OpenCLStream());
+		void				enqueueReadBuffer(cl_mem buffer, size_t offset, size_t cb, void *ptr, const OpenCLStream &stream = OpenCLStream());
+		void				enqueueCopyBuffer(cl_mem src_buffer, cl_mem dst_buffer, size_t src_offset, size_t dst_offset, size_t cb, const OpenCLStream &stream = OpenCLStream());
+		void				enqueueNDRangeKernel(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_offset,
+												 const size_t *global_work_size, const size_t *local_work_size, const OpenCLStream &stream = OpenCLStream());
+		// Completes after all commands enqueued to the in-order queue before it, OpenCL 1.x markers don't report their errors
+		OpenCLEvent			marker(const OpenCLStream &stream = OpenCLStream());
+
+		void				flush();
+		void				flush(const OpenCLStream &stream);
+		// Waits for all enqueued commands of all queues and throws the first execution error of non-blocking commands
+		void				finish();
+
+		// Opt-in device-side profiling of kernels and transfers, see profiler().printSummary().
+		// Recreates the default queue, named queues created before the call are not profiled.
+		void				setProfilingEnabled(bool enabled);
+		bool				isProfilingEnabled() const	{ return profiling_;				}
+		OpenCLProfiler &	profiler()					{ return profiler_;					}
+
 		const DeviceInfo &	deviceInfo() const			{ return device_info_;				}
 
 		cl_platform_id		platform()					{ return platform_id_;				}
 		cl_device_id		device()					{ return device_id_;				}
 		cl_context			context()					{ return context_;					}
 		cl_command_queue	queue()						{ return command_queue_;			}
+		// Named queues are created on first request (properties are used only then and only if supported by device),
+		// empty name means the default in-order queue
+		cl_command_queue	queue(const std::string &name, cl_command_queue_properties properties = 0);
+		OpenCLStream		stream(const std::string &name = std::string(), cl_command_queue_properties properties = 0)	{ return OpenCLStream(queue(name, properties));	}
 
 		const std::string &	deviceName()				{ return device_info_.device_name;				}
 		size_t				maxComputeUnits() const		{ return device_info_.max_compute_units;		}
@@ -173,18 +353,27 @@ namespace ocl {
 		size_t				maxWorkItemSizes(int dim)	{ return device_info_.max_work_item_sizes[dim];	}
 		size_t				maxMemAllocSize()			{ return device_info_.max_mem_alloc_size;		}
 		size_t				globalMemSize()				{ return device_info_.global_mem_size;			}
+		size_t				localMemSize() const		{ return device_info_.local_mem_size;			}
 		size_t				deviceAddressBits()			{ return device_info_.device_address_bits;		}
-		size_t 				wavefrontSize()				{ return wavefront_size_;						}
+		size_t 				wavefrontSize() const		{ return wavefront_size_;						}
 		size_t 				totalMemSize()				{ return total_mem_size_;						}
 
-		std::map<int, cl_program> &		programs()	{ return programs_;	}
-		std::map<int, OpenCLKernel *> &	kernels()	{ return kernels_;	}
-
-		cl_program						findProgram(int id) const;
-		OpenCLKernel *					findKernel(int id) const;
+		// Wait-free, programs and kernels can be built concurrently (see KernelRegistry) and are published only once
+		cl_program						findProgram(int id) const		{ return programs_.find(id);	}
+		OpenCLKernel *					findKernel(int id) const		{ return kernels_.find(id);		}
+		void							addProgram(int id, cl_program program);
+		void							addKernel(int id, OpenCLKernel *kernel);
 
 	protected:
-		void				trackEvent(cl_event ev, std::string message="");
+		void				checkNDRange(OpenCLKernel &kernel, cl_uint work_dim, const size_t *global_work_size, const size_t *local_work_size);
+		// name and bytes are used for profiling
+		void				trackEvent(cl_event ev, std::string message="", std::string name="", size_t bytes=0);
+		OpenCLEvent			trackEventAsync(cl_event ev, std::string message="", std::string name="", size_t bytes=0);
+		cl_event *			profilingEvent(cl_event *ev)			{ return profiling_ ? ev : NULL;					}
+		cl_command_queue_properties	queueProperties() const		{ return profiling_ ? CL_QUEUE_PROFILING_ENABLE : 0;	}
+		cl_command_queue	queueOf(const OpenCLStream &stream)		{ return stream.queue() ? stream.queue() : queue();	}
+		// The caller holds queues_mutex_ (or the engine is not shared yet)
+		void				updatePoolQueues();
 
 		cl_platform_id		platform_id_;
 		cl_device_id		device_id_;
@@ -196,8 +385,26 @@ namespace ocl {
 		DeviceInfo			device_info_;
 		size_t				total_mem_size_;
 
-		std::map<int, cl_program>		programs_;
-		std::map<int, OpenCLKernel *>	kernels_;
+		IdTable<cl_program>				programs_;
+		IdTable<OpenCLKernel *>			kernels_;
+
+		std::map<std::string, cl_command_queue>	queues_;
+		Mutex									queues_mutex_;
+
+		struct PendingEvent {
+			OpenCLEvent		event;
+			std::string		name;
+			size_t			bytes;
+		};
+
+		std::vector<PendingEvent>		pending_events_;
+		size_t							pending_events_limit_;	// completed events are dropped when it is reached
+		Mutex							pending_events_mutex_;
+
+		bool							profiling_;
+		OpenCLProfiler					profiler_;
+
+		std::shared_ptr<BufferPool>		buffer_pool_;
 	};
 
 	void		oclPrintBuildLog(cl_program program);
@@ -231,31 +438,94 @@ public:
 	std::string								defines() const { return defines_; }
 	const VersionedBinary*					getBinary(const std::shared_ptr<OpenCLEngine> &cl) const;
 	const std::string &						programName() const { return program_name_; };
+	// Held while the program is being built, so that it is built only once even if requested from several threads
+	Mutex &									buildMutex() const { return build_mutex_; }
 
 protected:
+	static int								getNextProgramId();
+
 	int										id_;
 	std::vector<VersionedBinary>			binaries_;
 	std::string								program_name_;
 	std::string								defines_;
+	mutable Mutex							build_mutex_;
 };
 
 class KernelSource {
 public:
 	KernelSource(std::shared_ptr<ocl::ProgramBinaries> program, const char *name);
 	KernelSource(std::shared_ptr<ocl::ProgramBinaries> program, const std::string &name);
+	KernelSource(const KernelSource &other);
+	~KernelSource();
 
 	typedef OpenCLKernel::Arg Arg;
 
-	void exec(const gpu::WorkSize &ws, const Arg &arg0 = Arg(), const Arg &arg1 = Arg(), const Arg &arg2 = Arg(), const Arg &arg3 = Arg(), const Arg &arg4 = Arg(), const Arg &arg5 = Arg(), const Arg &arg6 = Arg(), const Arg &arg7 = Arg(), const Arg &arg8 = Arg(), const Arg &arg9 = Arg(), const Arg &arg10 = Arg(), const Arg &arg11 = Arg(), const Arg &arg12 = Arg(), const Arg &arg13 = Arg(), const Arg &arg14 = Arg(), const Arg &arg15 = Arg(), const Arg &arg16 = Arg(), const Arg &arg17 = Arg(), const Arg &arg18 = Arg(), const Arg &arg19 = Arg(), const Arg &arg20 = Arg(), const Arg &arg21 = Arg(), const Arg &arg22 = Arg(), const Arg &arg23 = Arg(), const Arg &arg24 = Arg(), const Arg &arg25 = Arg(), const Arg &arg26 = Arg(), const Arg &arg27 = Arg(), const Arg &arg28 = Arg(), const Arg &arg29 = Arg(), const Arg &arg30 = Arg(), const Arg &arg31 = Arg(), const Arg &arg32 = Arg(), const Arg &arg33 = Arg(), const Arg &arg34 = Arg(), const Arg &arg35 = Arg(), const Arg &arg36 = Arg(), const Arg &arg37 = Arg(), const Arg &arg38 = Arg(), const Arg &arg39 = Arg(), const Arg &arg40 = Arg());
-	void execSubdivided(const gpu::WorkSize &ws, const Arg &arg0 = Arg(), const Arg &arg1 = Arg(), const Arg &arg2 = Arg(), const Arg &arg3 = Arg(), const Arg &arg4 = Arg(), const Arg &arg5 = Arg(), const Arg &arg6 = Arg(), const Arg &arg7 = Arg(), const Arg &arg8 = Arg(), const Arg &arg9 = Arg(), const Arg &arg10 = Arg(), const Arg &arg11 = Arg(), const Arg &arg12 = Arg(), const Arg &arg13 = Arg(), const Arg &arg14 = Arg(), const Arg &arg15 = Arg(), const Arg &arg16 = Arg(), const Arg &arg17 = Arg(), const Arg &arg18 = Arg(), const Arg &arg19 = Arg(), const Arg &arg20 = Arg(), const Arg &arg21 = Arg(), const Arg &arg22 = Arg(), const Arg &arg23 = Arg(), const Arg &arg24 = Arg(), const Arg &arg25 = Arg(), const Arg &arg26 = Arg(), const Arg &arg27 = Arg(), const Arg &arg28 = Arg(), const Arg &arg29 = Arg(), const Arg &arg30 = Arg(), const Arg &arg31 = Arg(), const Arg &arg32 = Arg(), const Arg &arg33 = Arg(), const Arg &arg34 = Arg(), const Arg &arg35 = Arg(), const Arg &arg36 = Arg(), const Arg &arg37 = Arg(), const Arg &arg38 = Arg(), const Arg &arg39 = Arg(), const Arg &arg40 = Arg());
-
+	// Only passed arguments are set, e.g. exec(ws, as_gpu, bs_gpu, cs_gpu, n)
+	template <typename... Args>
+	void exec(const gpu::WorkSize &ws, const Args &... args)
+	{
+		OpenCLKernelArgs<Args...> list(args...);
+		execArray(ws, list.data(), list.size());
+	}
+
+	template <typename... Args>
+	OpenCLEvent execAsync(const gpu::WorkSize &ws, const Args &... args)
+	{
+		OpenCLKernelArgs<Args...> list(args...);
+		return execAsyncArray(OpenCLStream(), ws, list.data(), list.size());
+	}
+
+	template <typename... Args>
+	OpenCLEvent execAsync(const OpenCLStream &stream, const gpu::WorkSize &ws, const Args &... args)
+	{
+		OpenCLKernelArgs<Args...> list(args...);
+		return execAsyncArray(stream, ws, list.data(), list.size());
+	}
+
+	template <typename... Args>
+	void execSubdivided(const gpu::WorkSize &ws, const Args &... args)
+	{
+		OpenCLKernelArgs<Args...> list(args...);
+		execSubdividedArray(ws, list.data(), list.size());
+	}
+
+	template <typename... Args>
+	void execTuned(const gpu::WorkSize &ws, const Args &... args)
+	{
+		OpenCLKernelArgs<Args...> list(args...);
+		execTunedArray(ws, list.data(), list.size());
+	}
+
+	void		execArray(const gpu::WorkSize &ws, const Arg *args, size_t nargs);
+	OpenCLEvent	execAsyncArray(const OpenCLStream &stream, const gpu::WorkSize &ws, const Arg *args, size_t nargs);
+	// Parts are enqueued back-to-back and waited for once. Part size is chosen so that one part takes about subdivisionLatency(),
+	// it is learned from the measured throughput of previous calls and persisted in DiskCache per kernel and device
+	void		execSubdividedArray(const gpu::WorkSize &ws, const Arg *args, size_t nargs);
+	// Local size is chosen per device: on the first call candidates within the kernel and device limits are benchmarked with these
+	// arguments (so the kernel must be safe to run several times with them), the fastest one is persisted in DiskCache and reused
+	// by later runs. The global size of ws is rounded up to the chosen local size, the local size of ws is one of the candidates
+	void		execTunedArray(const gpu::WorkSize &ws, const Arg *args, size_t nargs);
+	// Without an event, see OpenCLEngine::enqueueNDRangeKernel()
+	void		enqueueArray(const OpenCLStream &stream, const gpu::WorkSize &ws, const Arg *args, size_t nargs);
+
+	// Target duration of one execSubdivided() part in seconds, e.g. below the display driver watchdog timeout or a latency SLO (0.05 by default)
+	static void		setSubdivisionLatency(double seconds);
+	static double	subdivisionLatency();
+
+	// Blocks until the kernel is built, also waits for a concurrent build of its program (e.g. by KernelRegistry::precompileAll)
 	void precompile(bool printLog=false);
 	void precompile(const std::shared_ptr<OpenCLEngine> &cl, bool printLog=false);
 
+	const std::shared_ptr<ocl::ProgramBinaries> &	program() const	{ return program_;	}
+	const std::string &								name() const	{ return name_;		}
+
 protected:
-	int getNextKernelId();
+	static int getNextKernelId();
 
 	OpenCLKernel *getKernel(const std::shared_ptr<OpenCLEngine> &cl, bool printLog=false);
+	void		tuneWorkSize(const std::shared_ptr<OpenCLEngine> &cl, OpenCLKernel &kernel, const gpu::WorkSize &ws);
+	// DiskCache key of per kernel and device data, e.g. tuning results
+	std::string	tuningKey(const std::string &prefix, const std::shared_ptr<OpenCLEngine> &cl) const;
 
 	std::shared_ptr<ocl::ProgramBinaries> program_;
 
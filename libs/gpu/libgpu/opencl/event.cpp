@@ -0,0 +1,131 @@
+#include "event.h"
+#include "utils.h"
+
+#include <algorithm>
+
+namespace ocl {
+
+OpenCLEvent::OpenCLEvent()
+{
+	event_	= 0;
+}
+
+OpenCLEvent::OpenCLEvent(cl_event event, std::string message)
+{
+	event_		= event;
+	message_	= message;
+}
+
+OpenCLEvent::OpenCLEvent(const OpenCLEvent &other)
+{
+	event_		= other.event_;
+	message_	= other.message_;
+	if (event_)
+		clRetainEvent(event_);
+}
+
+OpenCLEvent &OpenCLEvent::operator= (const OpenCLEvent &other)
+{
+	if (this != &other) {
+		OpenCLEvent tmp(other);
+		swap(tmp);
+	}
+
+	return *this;
+}
+
+OpenCLEvent::~OpenCLEvent()
+{
+	reset();
+}
+
+void OpenCLEvent::swap(OpenCLEvent &other)
+{
+	std::swap(event_,	other.event_);
+	std::swap(message_,	other.message_);
+}
+
+void OpenCLEvent::reset()
+{
+	if (event_)
+		clReleaseEvent(event_);
+	event_ = 0;
+	message_.clear();
+}
+
+void OpenCLEvent::wait() const
+{
+	if (!event_)
+		return;
+
+	cl_int ciErrNum = clWaitForEvents(1, &event_);
+	if (ciErrNum != CL_SUCCESS && ciErrNum != CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST)
+		OCL_SAFE_CALL_MESSAGE(ciErrNum, message_);
+
+	cl_int result = status();
+	if (result < 0)
+		OCL_SAFE_CALL_MESSAGE(result, message_);
+
+	if (result != CL_COMPLETE)
+		throw ocl_exception(message_ + "Wait for event succeed, but it is still is not complete with execution status: " + to_string(result) + "!");
+}
+
+bool OpenCLEvent::isComplete() const
+{
+	if (!event_)
+		return true;
+
+	cl_int result = status();
+	return result == CL_COMPLETE || result < 0;
+}
+
+int OpenCLEvent::status() const
+{
+	if (!event_)
+		return CL_COMPLETE;
+
+	cl_int result = CL_COMPLETE;
+	OCL_SAFE_CALL_MESSAGE(clGetEventInfo(event_, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(cl_int), &result, 0), message_);
+	return result;
+}
+
+void OpenCLStream::flushQueueOf(const OpenCLEvent &event) const
+{
+	cl_command_queue queue = 0;
+	OCL_SAFE_CALL_MESSAGE(clGetEventInfo(event.event(), CL_EVENT_COMMAND_QUEUE, sizeof(queue), &queue, 0), event.message());
+	// user events have no queue
+	if (queue && queue != queue_)
+		OCL_SAFE_CALL_MESSAGE(clFlush(queue), event.message());
+}
+
+OpenCLStream OpenCLStream::after(const OpenCLEvent &event) const
+{
+	OpenCLStream res = *this;
+	if (!event.isNull()) {
+		flushQueueOf(event);
+		res.wait_list_.push_back(event);
+	}
+	return res;
+}
+
+OpenCLStream OpenCLStream::after(const std::vector<OpenCLEvent> &events) const
+{
+	OpenCLStream res = *this;
+	for (size_t i = 0; i < events.size(); ++i) {
+		if (!events[i].isNull()) {
+			flushQueueOf(events[i]);
+			res.wait_list_.push_back(events[i]);
+		}
+	}
+	return res;
+}
+
+std::vector<cl_event> OpenCLStream::waitEvents() const
+{
+	std::vector<cl_event> events(wait_list_.size());
+	for (size_t i = 0; i < wait_list_.size(); ++i)
+		events[i] = wait_list_[i].event();
+	return events;
+}
+
+}
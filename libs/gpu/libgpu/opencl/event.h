@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+typedef struct _cl_event *			cl_event;
+typedef struct _cl_command_queue *	cl_command_queue;
+
+namespace ocl {
+
+// Reference counted handle of an enqueued OpenCL command.
+// Execution errors of the command are reported by wait() instead of the enqueue call.
+class OpenCLEvent {
+public:
+	OpenCLEvent();
+	explicit OpenCLEvent(cl_event event, std::string message = std::string());
+	OpenCLEvent(const OpenCLEvent &other);
+	OpenCLEvent &operator= (const OpenCLEvent &other);
+	~OpenCLEvent();
+
+	void				swap(OpenCLEvent &other);
+	void				reset();
+	bool				isNull() const					{ return event_ == 0;	}
+
+	// Blocks until the command is finished, throws ocl_exception if it failed
+	void				wait() const;
+	// Non-blocking query, failed command is treated as completed (its error is thrown by wait())
+	bool				isComplete() const;
+	// Returns CL_COMPLETE, CL_RUNNING, CL_SUBMITTED, CL_QUEUED or negative error code
+	int					status() const;
+
+	cl_event			event() const					{ return event_;		}
+	const std::string &	message() const					{ return message_;		}
+
+protected:
+	cl_event			event_;
+	std::string			message_;
+};
+
+// Command queue of an engine plus the events which the next command enqueued to it has to wait for.
+// Null queue means the default queue of the engine. The queue is owned by the engine.
+class OpenCLStream {
+public:
+	OpenCLStream() : queue_(0)										{ }
+	explicit OpenCLStream(cl_command_queue queue) : queue_(queue)	{ }
+
+	// Returns a copy of this stream that additionally waits for the given event (possibly from another queue).
+	// OpenCL requires the queue of the event to be flushed before another queue waits for it, so that queue is flushed here
+	OpenCLStream						after(const OpenCLEvent &event) const;
+	OpenCLStream						after(const std::vector<OpenCLEvent> &events) const;
+
+	cl_command_queue					queue() const		{ return queue_;		}
+	const std::vector<OpenCLEvent> &	waitList() const	{ return wait_list_;	}
+	std::vector<cl_event>				waitEvents() const;
+
+protected:
+	void						flushQueueOf(const OpenCLEvent &event) const;
+
+	cl_command_queue			queue_;
+	std::vector<OpenCLEvent>	wait_list_;
+};
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include <libgpu/opencl/utils.h>
+
+namespace ocl {
+
+// Pointers indexed by dense ids (kernel and program ids start from zero).
+// Lookups are wait-free and publishing is lock-free: chunks of slots are allocated on demand and never move.
+template <typename T>
+class IdTable {
+public:
+	IdTable()
+	{
+		for (size_t i = 0; i < max_chunks; ++i)
+			chunks_[i].store(0, std::memory_order_relaxed);
+	}
+
+	~IdTable()
+	{
+		for (size_t i = 0; i < max_chunks; ++i)
+			delete [] chunks_[i].load(std::memory_order_relaxed);
+	}
+
+	T find(int id) const
+	{
+		if (id < 0 || (size_t) id >= max_chunks * chunk_size)
+			return 0;
+
+		const std::atomic<T> *chunk = chunks_[id / chunk_size].load(std::memory_order_acquire);
+		if (!chunk)
+			return 0;
+
+		return chunk[id % chunk_size].load(std::memory_order_acquire);
+	}
+
+	// Returns false if the id already has a value, value is not published then
+	bool publish(int id, T value)
+	{
+		if (id < 0 || (size_t) id >= max_chunks * chunk_size)
+			throw ocl_exception("Id " + to_string(id) + " is out of table range!");
+
+		std::atomic<T> *chunk = chunks_[id / chunk_size].load(std::memory_order_acquire);
+		if (!chunk) {
+			std::atomic<T> *fresh = new std::atomic<T>[chunk_size];
+			for (size_t i = 0; i < chunk_size; ++i)
+				fresh[i].store(0, std::memory_order_relaxed);
+
+			if (chunks_[id / chunk_size].compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+				chunk = fresh;
+			} else {
+				delete [] fresh;
+			}
+		}
+
+		T expected = 0;
+		return chunk[id % chunk_size].compare_exchange_strong(expected, value, std::memory_order_acq_rel, std::memory_order_acquire);
+	}
+
+	// Not thread-safe, calls f for every published value
+	template <typename F>
+	void forEach(F f) const
+	{
+		for (size_t i = 0; i < max_chunks; ++i) {
+			const std::atomic<T> *chunk = chunks_[i].load(std::memory_order_acquire);
+			if (!chunk)
+				continue;
+
+			for (size_t j = 0; j < chunk_size; ++j) {
+				T value = chunk[j].load(std::memory_order_acquire);
+				if (value)
+					f(value);
+			}
+		}
+	}
+
+protected:
+	static const size_t			chunk_size = 256;
+	static const size_t			max_chunks = 4096;
+
+	IdTable(const IdTable &);
+	IdTable &operator= (const IdTable &);
+
+	std::atomic<std::atomic<T> *>	chunks_[max_chunks];
+};
+
+}
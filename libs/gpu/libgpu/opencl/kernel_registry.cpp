@@ -0,0 +1,126 @@
+#include "kernel_registry.h"
+#include "engine.h"
+
+#include <libgpu/context.h>
+
+#include <map>
+#include <algorithm>
+
+namespace ocl {
+
+KernelRegistry &KernelRegistry::instance()
+{
+	// constructed on the first registration, so it outlives static KernelSource objects
+	static KernelRegistry registry;
+	return registry;
+}
+
+KernelRegistry::~KernelRegistry()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.clear();
+	}
+
+	for (size_t i = 0; i < workers_.size(); ++i)
+		workers_[i].join();
+}
+
+void KernelRegistry::add(KernelSource *kernel)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	kernels_.insert(kernel);
+}
+
+void KernelRegistry::remove(KernelSource *kernel)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	kernels_.erase(kernel);
+	while (compiling_.count(kernel))
+		compiled_.wait(lock);
+}
+
+void KernelRegistry::precompileAll(const std::shared_ptr<OpenCLEngine> &cl, size_t nthreads)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::map<int, Task> programs;
+	for (std::set<KernelSource *>::const_iterator it = kernels_.begin(); it != kernels_.end(); ++it) {
+		Task &task = programs[(*it)->program()->id()];
+		task.cl = cl;
+		task.kernels.push_back(*it);
+	}
+
+	for (std::map<int, Task>::iterator it = programs.begin(); it != programs.end(); ++it)
+		tasks_.push_back(it->second);
+
+	if (nthreads == 0)
+		nthreads = std::max(std::thread::hardware_concurrency(), 1u);
+	nthreads = std::min(nthreads, programs.size());
+
+	for (size_t i = 0; i < nthreads; ++i)
+		workers_.push_back(std::thread(&KernelRegistry::worker, this));
+}
+
+void KernelRegistry::precompileAll(size_t nthreads)
+{
+	gpu::Context context;
+	precompileAll(context.cl(), nthreads);
+}
+
+void KernelRegistry::wait()
+{
+	std::vector<std::thread> workers;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		workers.swap(workers_);
+	}
+
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+
+	std::string error;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		error.swap(error_);
+	}
+
+	if (!error.empty())
+		throw ocl_exception(error);
+}
+
+void KernelRegistry::worker()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	while (!tasks_.empty()) {
+		Task task = tasks_.back();
+		tasks_.pop_back();
+
+		for (size_t i = 0; i < task.kernels.size(); ++i) {
+			KernelSource *kernel = task.kernels[i];
+
+			// destroyed after the task was created
+			if (!kernels_.count(kernel) || compiling_.count(kernel))
+				continue;
+
+			compiling_.insert(kernel);
+			lock.unlock();
+
+			std::string error;
+			try {
+				kernel->precompile(task.cl);
+			} catch (const std::exception &e) {
+				error = e.what();
+			}
+
+			lock.lock();
+			compiling_.erase(kernel);
+			if (error_.empty())
+				error_ = error;
+			compiled_.notify_all();
+		}
+	}
+}
+
+}
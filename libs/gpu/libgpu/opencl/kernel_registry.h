@@ -0,0 +1,56 @@
+#pragma once
+
+#include <set>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+namespace ocl {
+
+class OpenCLEngine;
+class KernelSource;
+
+// All alive KernelSource objects (including the ones behind ocl::Kernel) register themselves here,
+// so that their programs can be built on worker threads while the application does other startup work.
+class KernelRegistry {
+public:
+	static KernelRegistry &		instance();
+
+	~KernelRegistry();
+
+	void						add(KernelSource *kernel);
+	// Waits if the kernel is being compiled by a worker thread right now
+	void						remove(KernelSource *kernel);
+
+	// Starts building programs of all registered kernels on nthreads worker threads (0 means one per CPU core) and returns immediately.
+	// KernelSource::precompile() blocks until a specific kernel is ready (waiting for the worker that builds its program),
+	// wait() blocks until all of them are built.
+	void						precompileAll(const std::shared_ptr<OpenCLEngine> &cl, size_t nthreads = 0);
+	// For the engine of the current gpu::Context
+	void						precompileAll(size_t nthreads = 0);
+	// Joins all workers, throws ocl_exception with the first compilation error
+	void						wait();
+
+protected:
+	KernelRegistry()			{ }
+
+	struct Task {
+		std::shared_ptr<OpenCLEngine>	cl;
+		std::vector<KernelSource *>		kernels;	// all kernels of one program
+	};
+
+	void						worker();
+
+	std::mutex					mutex_;
+	std::condition_variable		compiled_;
+	std::set<KernelSource *>	kernels_;
+	std::set<KernelSource *>	compiling_;
+	std::vector<Task>			tasks_;
+	std::vector<std::thread>	workers_;
+	std::string					error_;
+};
+
+}
@@ -0,0 +1,187 @@
+#include "multi_device_executor.h"
+
+#include <libutils/timer.h>
+
+#include <limits>
+#include <thread>
+#include <algorithm>
+
+namespace ocl {
+
+MultiDeviceExecutor::MultiDeviceExecutor(const std::vector<gpu::Device> &devices)
+{
+	for (size_t i = 0; i < devices.size(); ++i) {
+		const gpu::Device &device = devices[i];
+		if (!device.supports_opencl)
+			throw ocl_exception("Device " + device.name + " doesn't support OpenCL!");
+
+		DeviceState state;
+		state.context.init(device.device_id_opencl);
+		state.weight			= std::max((double) device.compute_units * device.clock, 1.0);
+		state.weight_measured	= false;
+		state.throughput		= 0.0;
+		devices_.push_back(state);
+	}
+
+	if (devices_.empty())
+		throw ocl_exception("No devices for the multi-device executor!");
+}
+
+MultiDeviceExecutor::~MultiDeviceExecutor()
+{
+	// contexts are released in a thread without an active context, so they don't complain about the context of this thread
+	std::thread release([this]() {
+		devices_.clear();
+	});
+	release.join();
+}
+
+MultiDeviceExecutor &MultiDeviceExecutor::input(const void *data, size_t unit_size)
+{
+	if (unit_size == 0)
+		throw ocl_exception("Zero unit size of a sliced array!");
+	arrays_.push_back(Array(Input, const_cast<void *>(data), unit_size));
+	return *this;
+}
+
+MultiDeviceExecutor &MultiDeviceExecutor::output(void *data, size_t unit_size)
+{
+	if (unit_size == 0)
+		throw ocl_exception("Zero unit size of a sliced array!");
+	arrays_.push_back(Array(Output, data, unit_size));
+	return *this;
+}
+
+MultiDeviceExecutor &MultiDeviceExecutor::broadcast(const void *data, size_t size)
+{
+	if (size == 0)
+		throw ocl_exception("Empty broadcast array!");
+	arrays_.push_back(Array(Broadcast, const_cast<void *>(data), size));
+	return *this;
+}
+
+void MultiDeviceExecutor::clear()
+{
+	arrays_.clear();
+}
+
+void MultiDeviceExecutor::execArray(KernelSource &kernel, const gpu::WorkSize &ws, size_t n, const Arg *args, size_t nargs)
+{
+	if (n == 0)
+		return;
+
+	int dim = ws.clWorkDim();
+	if (dim != 1 && dim != 2)
+		throw ocl_exception("Only 1D and 2D work sizes can be split between devices!");
+
+	// the number of units is passed as unsigned int
+	if (n > std::numeric_limits<unsigned int>::max())
+		throw ocl_exception("Too many units for the multi-device executor: " + to_string(n));
+
+	// slices are whole work groups along the split dimension, except the last one
+	size_t group_size	= ws.clLocalSize()[dim - 1];
+	size_t ngroups		= (n + group_size - 1) / group_size;
+
+	double total_weight = 0.0;
+	for (size_t i = 0; i < devices_.size(); ++i)
+		total_weight += devices_[i].weight;
+
+	std::vector<size_t> offsets(devices_.size());
+	std::vector<size_t> units(devices_.size());
+	size_t assigned_groups = 0;
+	double accumulated_weight = 0.0;
+	for (size_t i = 0; i < devices_.size(); ++i) {
+		accumulated_weight += devices_[i].weight;
+		size_t end_groups = (i + 1 == devices_.size()) ? ngroups : std::min((size_t) (ngroups * accumulated_weight / total_weight + 0.5), ngroups);
+		end_groups = std::max(end_groups, assigned_groups);
+
+		offsets[i]	= std::min(assigned_groups * group_size, n);
+		units[i]	= std::min(end_groups * group_size, n) - offsets[i];
+		assigned_groups = end_groups;
+	}
+
+	std::vector<std::string> errors(devices_.size());
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < devices_.size(); ++i) {
+		if (units[i] == 0)
+			continue;
+
+		devices_[i].buffers.resize(arrays_.size());
+		workers.push_back(std::thread([&, i]() {
+			try {
+				run(i, kernel, ws, offsets[i], units[i], args, nargs);
+			} catch (const std::exception &e) {
+				errors[i] = e.what();
+			}
+		}));
+	}
+
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+
+	for (size_t i = 0; i < devices_.size(); ++i) {
+		if (!errors[i].empty())
+			throw ocl_exception(errors[i]);
+	}
+
+	// throughput includes transfers, it is smoothed because a single launch may be noisy
+	for (size_t i = 0; i < devices_.size(); ++i) {
+		DeviceState &state = devices_[i];
+		if (units[i] == 0 || state.throughput <= 0.0)
+			continue;
+
+		state.weight = state.weight_measured ? 0.5 * state.weight + 0.5 * state.throughput : state.throughput;
+		state.weight_measured = true;
+	}
+}
+
+void MultiDeviceExecutor::run(size_t device, KernelSource &kernel, const gpu::WorkSize &ws, size_t offset, size_t units,
+							  const Arg *args, size_t nargs)
+{
+	DeviceState &state = devices_[device];
+
+	gpu::Context context = state.context;
+	context.activate();
+
+	timer tm;
+
+	std::vector<Arg> kernel_args;
+	for (size_t i = 0; i < arrays_.size(); ++i) {
+		const Array &array = arrays_[i];
+		gpu::shared_device_buffer &buffer = state.buffers[i];
+
+		size_t size = array.type == Broadcast ? array.size : units * array.size;
+		if (buffer.size() < size)
+			buffer.resize(size);
+
+		if (array.type == Input)
+			buffer.write((const char *) array.data + offset * array.size, size);
+		else if (array.type == Broadcast)
+			buffer.write(array.data, size);
+
+		kernel_args.push_back(Arg(buffer));
+	}
+	// Arg keeps a pointer to the value, so the count must outlive the launch
+	unsigned int units32 = (unsigned int) units;
+	kernel_args.insert(kernel_args.end(), args, args + nargs);
+	kernel_args.push_back(Arg(units32));
+
+	const size_t *local = ws.clLocalSize();
+	if (ws.clWorkDim() == 1) {
+		kernel.execArray(gpu::WorkSize((unsigned int) local[0], (unsigned int) units), kernel_args.data(), kernel_args.size());
+	} else {
+		kernel.execArray(gpu::WorkSize((unsigned int) local[0], (unsigned int) local[1], (unsigned int) ws.clGlobalSize()[0], (unsigned int) units),
+						 kernel_args.data(), kernel_args.size());
+	}
+
+	for (size_t i = 0; i < arrays_.size(); ++i) {
+		const Array &array = arrays_[i];
+		if (array.type == Output)
+			state.buffers[i].read((char *) array.data + offset * array.size, units * array.size);
+	}
+
+	double elapsed = tm.elapsed();
+	state.throughput = elapsed > 0.0 ? units / elapsed : 0.0;
+}
+
+}
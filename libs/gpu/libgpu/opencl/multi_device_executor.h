@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include <libgpu/context.h>
+#include <libgpu/device.h>
+#include <libgpu/opencl/engine.h>
+#include <libgpu/shared_device_buffer.h>
+
+namespace ocl {
+
+// Runs one 1D or 2D launch of a kernel on several OpenCL devices (e.g. CPU sockets exposed as separate devices or a CPU and an iGPU).
+// The work is split along x for 1D and along y (rows) for 2D in proportion to the throughput of devices measured by previous calls
+// (compute units are used before the first call). Every device works in its own thread with its own gpu::Context, so each program
+// is built once per device. Sliced arrays are scattered to the devices before the launch and gathered back after it.
+// The kernel is called as kernel(arrays..., args..., unsigned int n) where arrays are in the order of declaration and
+// n is the number of units (work items for 1D, rows for 2D) in the slice of the device. Indices are slice-local.
+class MultiDeviceExecutor {
+public:
+	typedef OpenCLKernel::Arg Arg;
+
+	explicit MultiDeviceExecutor(const std::vector<gpu::Device> &devices);
+	~MultiDeviceExecutor();
+
+	// unit_size is the number of bytes per work item (1D) or per row (2D)
+	MultiDeviceExecutor &	input(const void *data, size_t unit_size);
+	MultiDeviceExecutor &	output(void *data, size_t unit_size);
+	// Copied to every device as a whole
+	MultiDeviceExecutor &	broadcast(const void *data, size_t size);
+
+	// Blocks until all devices are finished, n is the total number of units. Args must be scalars (they are passed to all devices)
+	template <typename... Args>
+	void				exec(KernelSource &kernel, const gpu::WorkSize &ws, size_t n, const Args &... args)
+	{
+		OpenCLKernelArgs<Args...> list(args...);
+		execArray(kernel, ws, n, list.data(), list.size());
+	}
+
+	void				execArray(KernelSource &kernel, const gpu::WorkSize &ws, size_t n, const Arg *args, size_t nargs);
+
+	// Forgets declared arrays, device buffers are kept for reuse
+	void				clear();
+
+	size_t				devicesCount() const				{ return devices_.size();			}
+	// Units per second measured by the last call (0 if the device was not used yet)
+	double				throughput(size_t device) const		{ return devices_[device].throughput;	}
+
+protected:
+	enum ArrayType {
+		Input,
+		Output,
+		Broadcast,
+	};
+
+	struct Array {
+		Array(ArrayType type, void *data, size_t size) : type(type), data(data), size(size) {}
+
+		ArrayType		type;
+		void *			data;
+		size_t			size;			// per unit for sliced arrays
+	};
+
+	struct DeviceState {
+		gpu::Context							context;
+		double									weight;
+		bool									weight_measured;
+		double									throughput;
+		std::vector<gpu::shared_device_buffer>	buffers;
+	};
+
+	void				run(size_t device, KernelSource &kernel, const gpu::WorkSize &ws, size_t offset, size_t units,
+							const Arg *args, size_t nargs);
+
+	std::vector<DeviceState>	devices_;
+	std::vector<Array>			arrays_;
+
+private:
+	MultiDeviceExecutor(const MultiDeviceExecutor &);
+	MultiDeviceExecutor &operator= (const MultiDeviceExecutor &);
+};
+
+}
@@ -0,0 +1,129 @@
+#include "profiler.h"
+#include "utils.h"
+
+#include <cmath>
+#include <iomanip>
+#include <algorithm>
+
+namespace ocl {
+
+static double percentile(std::vector<double> &values, double p)
+{
+	if (values.empty())
+		return 0.0;
+
+	// nearest-rank method
+	size_t rank = (size_t) std::ceil(p * values.size());
+	rank = std::min(std::max(rank, (size_t) 1), values.size());
+	std::nth_element(values.begin(), values.begin() + (rank - 1), values.end());
+	return values[rank - 1];
+}
+
+void OpenCLProfiler::record(const std::string &name, cl_event event, size_t bytes)
+{
+	cl_ulong queued = 0, submit = 0, start = 0, end = 0;
+
+	if (clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_QUEUED, sizeof(cl_ulong), &queued, NULL) != CL_SUCCESS)
+		return;
+	OCL_SAFE_CALL(clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_SUBMIT,	sizeof(cl_ulong), &submit,	NULL));
+	OCL_SAFE_CALL(clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START,	sizeof(cl_ulong), &start,	NULL));
+	OCL_SAFE_CALL(clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END,		sizeof(cl_ulong), &end,		NULL));
+
+	Sample sample;
+	sample.submit_delay	= (submit > queued)	? (submit - queued)	* 1e-9 : 0.0;
+	sample.queue_delay	= (start > queued)	? (start - queued)	* 1e-9 : 0.0;
+	sample.exec			= (end > start)		? (end - start)		* 1e-9 : 0.0;
+
+	Lock lock(mutex_);
+	Samples &samples = samples_[name];
+	samples.samples.push_back(sample);
+	samples.bytes += bytes;
+}
+
+void OpenCLProfiler::clear()
+{
+	Lock lock(mutex_);
+	samples_.clear();
+}
+
+std::map<std::string, OpenCLProfiler::Stats> OpenCLProfiler::stats() const
+{
+	std::map<std::string, Stats> res;
+
+	Lock lock(mutex_);
+
+	for (std::map<std::string, Samples>::const_iterator it = samples_.begin(); it != samples_.end(); ++it) {
+		const std::vector<Sample> &samples = it->second.samples;
+
+		std::vector<double> exec(samples.size());
+		std::vector<double> queue_delay(samples.size());
+
+		Stats stats;
+		stats.count = samples.size();
+		stats.bytes = it->second.bytes;
+		for (size_t i = 0; i < samples.size(); ++i) {
+			exec[i]			= samples[i].exec;
+			queue_delay[i]	= samples[i].queue_delay;
+
+			stats.total_exec		+= samples[i].exec;
+			stats.mean_submit_delay	+= samples[i].submit_delay;
+			stats.mean_queue_delay	+= samples[i].queue_delay;
+		}
+
+		if (stats.count) {
+			stats.mean_exec			= stats.total_exec / stats.count;
+			stats.mean_submit_delay	/= stats.count;
+			stats.mean_queue_delay	/= stats.count;
+		}
+
+		stats.p50_exec			= percentile(exec, 0.50);
+		stats.p99_exec			= percentile(exec, 0.99);
+		stats.p50_queue_delay	= percentile(queue_delay, 0.50);
+		stats.p99_queue_delay	= percentile(queue_delay, 0.99);
+
+		res[it->first] = stats;
+	}
+
+	return res;
+}
+
+void OpenCLProfiler::printSummary(std::ostream &out) const
+{
+	std::map<std::string, Stats> all_stats = stats();
+
+	std::vector<std::pair<double, std::string> > order;
+	for (std::map<std::string, Stats>::const_iterator it = all_stats.begin(); it != all_stats.end(); ++it)
+		order.push_back(std::make_pair(-it->second.total_exec, it->first));
+	std::sort(order.begin(), order.end());
+
+	const double ms = 1000.0;
+
+	std::ios_base::fmtflags flags = out.flags();
+	std::streamsize precision = out.precision();
+
+	out << std::left << std::setw(32) << "name" << std::right
+		<< std::setw(8) << "count" << std::setw(12) << "total ms" << std::setw(12) << "mean ms"
+		<< std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms"
+		<< std::setw(14) << "submit ms" << std::setw(14) << "queue p50 ms" << std::setw(14) << "queue p99 ms"
+		<< std::setw(10) << "GB/s" << std::endl;
+
+	out << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < order.size(); ++i) {
+		const Stats &s = all_stats[order[i].second];
+		out << std::left << std::setw(32) << order[i].second << std::right
+			<< std::setw(8) << s.count << std::setw(12) << s.total_exec * ms << std::setw(12) << s.mean_exec * ms
+			<< std::setw(12) << s.p50_exec * ms << std::setw(12) << s.p99_exec * ms
+			<< std::setw(14) << s.mean_submit_delay * ms << std::setw(14) << s.p50_queue_delay * ms << std::setw(14) << s.p99_queue_delay * ms;
+		if (s.bytes && s.total_exec > 0) {
+			out << std::setw(10) << s.bytes / s.total_exec / (1024.0 * 1024.0 * 1024.0);
+		} else {
+			out << std::setw(10) << "-";
+		}
+		out << std::endl;
+	}
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include <libutils/thread_mutex.h>
+
+typedef struct _cl_event *			cl_event;
+
+namespace ocl {
+
+// Aggregates device-side timings (CL_PROFILING_COMMAND_*) of finished commands by name.
+// Events from queues without CL_QUEUE_PROFILING_ENABLE are silently ignored.
+class OpenCLProfiler {
+public:
+	struct Stats {
+		Stats() : count(0), bytes(0), total_exec(0), mean_exec(0), p50_exec(0), p99_exec(0),
+				  mean_submit_delay(0), mean_queue_delay(0), p50_queue_delay(0), p99_queue_delay(0) { }
+
+		size_t		count;
+		size_t		bytes;
+		// all times are in seconds
+		double		total_exec;
+		double		mean_exec;
+		double		p50_exec;
+		double		p99_exec;
+		double		mean_submit_delay;	// from enqueue to submission to device
+		double		mean_queue_delay;	// from enqueue to execution start
+		double		p50_queue_delay;
+		double		p99_queue_delay;
+	};
+
+	// Event should be finished
+	void							record(const std::string &name, cl_event event, size_t bytes = 0);
+	void							clear();
+
+	std::map<std::string, Stats>	stats() const;
+	void							printSummary(std::ostream &out = std::cout) const;
+
+protected:
+	struct Sample {
+		double	submit_delay;
+		double	queue_delay;
+		double	exec;
+	};
+
+	struct Samples {
+		Samples() : bytes(0) { }
+
+		std::vector<Sample>	samples;
+		size_t				bytes;
+	};
+
+	std::map<std::string, Samples>	samples_;
+	Mutex							mutex_;
+};
+
+}
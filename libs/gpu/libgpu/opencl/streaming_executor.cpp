@@ -0,0 +1,168 @@
+#include "streaming_executor.h"
+
+#include <libgpu/context.h>
+
+#include <limits>
+#include <algorithm>
+
+namespace ocl {
+
+StreamingExecutor::StreamingExecutor(size_t tile_size, size_t nslots)
+{
+	gpu::Context context;
+	engine_					= context.cl();
+	tile_size_				= tile_size;
+	allocated_tile_size_	= 0;
+
+	slots_.resize(std::max(nslots, (size_t) 1));
+}
+
+StreamingExecutor &StreamingExecutor::input(const void *data, size_t element_size)
+{
+	inputs_.push_back(Array(const_cast<void *>(data), element_size));
+	return *this;
+}
+
+StreamingExecutor &StreamingExecutor::output(void *data, size_t element_size)
+{
+	outputs_.push_back(Array(data, element_size));
+	return *this;
+}
+
+void StreamingExecutor::clear()
+{
+	inputs_.clear();
+	outputs_.clear();
+
+	for (size_t i = 0; i < slots_.size(); ++i)
+		slots_[i] = Slot();
+	allocated_tile_size_ = 0;
+}
+
+size_t StreamingExecutor::tileSize(unsigned int group_size) const
+{
+	if (tile_size_)
+		return tile_size_;
+
+	size_t element_size = 0;
+	size_t max_element_size = 1;
+	for (size_t i = 0; i < inputs_.size(); ++i) {
+		element_size += inputs_[i].element_size;
+		max_element_size = std::max(max_element_size, inputs_[i].element_size);
+	}
+	for (size_t i = 0; i < outputs_.size(); ++i) {
+		element_size += outputs_[i].element_size;
+		max_element_size = std::max(max_element_size, outputs_[i].element_size);
+	}
+
+	size_t tile_size = engine_->globalMemSize() / 4 / slots_.size() / std::max(element_size, (size_t) 1);
+	tile_size = std::min(tile_size, engine_->maxMemAllocSize() / max_element_size);
+	// the number of elements is passed as unsigned int
+	tile_size = std::min(tile_size, (size_t) std::numeric_limits<unsigned int>::max() - group_size);
+
+	group_size = std::max(group_size, 1u);
+	return std::max(tile_size / group_size * group_size, (size_t) group_size);
+}
+
+void StreamingExecutor::allocate(size_t tile_size)
+{
+	for (size_t i = 0; i < slots_.size(); ++i) {
+		Slot &slot = slots_[i];
+		if (tile_size == allocated_tile_size_ && slot.inputs.size() == inputs_.size() && slot.outputs.size() == outputs_.size())
+			continue;
+
+		slot.inputs.resize(inputs_.size());
+		slot.outputs.resize(outputs_.size());
+		for (size_t j = 0; j < inputs_.size(); ++j)
+			slot.inputs[j].resize(tile_size * inputs_[j].element_size);
+		for (size_t j = 0; j < outputs_.size(); ++j)
+			slot.outputs[j].resize(tile_size * outputs_[j].element_size);
+	}
+
+	allocated_tile_size_ = tile_size;
+}
+
+void StreamingExecutor::execArray(KernelSource &kernel, size_t n, unsigned int group_size, const Arg *args, size_t nargs)
+{
+	if (n == 0)
+		return;
+
+	if (inputs_.empty() && outputs_.empty())
+		throw ocl_exception("No arrays are bound to the streaming executor!");
+
+	size_t tile_size = tileSize(group_size);
+	allocate(tile_size);
+
+	OpenCLStream upload		= engine_->stream("streaming_upload");
+	OpenCLStream compute	= engine_->stream("streaming_compute");
+	OpenCLStream download	= engine_->stream("streaming_download");
+
+	std::string error;
+	std::vector<OpenCLEvent> uploads;
+	try {
+		for (size_t offset = 0, tile = 0; offset < n; offset += tile_size, ++tile) {
+			Slot &slot = slots_[tile % slots_.size()];
+			unsigned int count = (unsigned int) std::min(tile_size, n - offset);
+
+			// inputs of the slot are free when its previous kernel is finished
+			uploads.clear();
+			for (size_t i = 0; i < inputs_.size(); ++i) {
+				size_t element_size = inputs_[i].element_size;
+				uploads.push_back(engine_->writeBufferAsync(slot.inputs[i].clmem(), 0, count * element_size,
+															(const char *) inputs_[i].data + offset * element_size, upload.after(slot.kernel)));
+			}
+			// events of a queue may be waited for by another queue only after it is flushed
+			engine_->flush(upload);
+
+			// outputs of the slot are free when its previous downloads are finished
+			std::vector<Arg> kernel_args;
+			for (size_t i = 0; i < inputs_.size(); ++i)
+				kernel_args.push_back(Arg(slot.inputs[i]));
+			for (size_t i = 0; i < outputs_.size(); ++i)
+				kernel_args.push_back(Arg(slot.outputs[i]));
+			kernel_args.insert(kernel_args.end(), args, args + nargs);
+			kernel_args.push_back(Arg(count));
+
+			slot.kernel = kernel.execAsyncArray(compute.after(uploads).after(slot.downloads), gpu::WorkSize(group_size, count),
+												kernel_args.data(), kernel_args.size());
+			engine_->flush(compute);
+
+			slot.downloads.clear();
+			for (size_t i = 0; i < outputs_.size(); ++i) {
+				size_t element_size = outputs_[i].element_size;
+				slot.downloads.push_back(engine_->readBufferAsync(slot.outputs[i].clmem(), 0, count * element_size,
+																  (char *) outputs_[i].data + offset * element_size, download.after(slot.kernel)));
+			}
+			engine_->flush(download);
+		}
+	} catch (const std::exception &e) {
+		error = e.what();
+	}
+
+	// host arrays must not be used by transfers after the return, even if something failed
+	for (size_t i = 0; i < slots_.size(); ++i) {
+		Slot &slot = slots_[i];
+
+		std::vector<OpenCLEvent> events = slot.downloads;
+		events.push_back(slot.kernel);
+		if (i == 0)
+			events.insert(events.end(), uploads.begin(), uploads.end());
+		for (size_t j = 0; j < events.size(); ++j) {
+			try {
+				if (!events[j].isNull())
+					events[j].wait();
+			} catch (const std::exception &e) {
+				if (error.empty())
+					error = e.what();
+			}
+		}
+
+		slot.kernel.reset();
+		slot.downloads.clear();
+	}
+
+	if (!error.empty())
+		throw ocl_exception(error);
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include <libgpu/opencl/engine.h>
+#include <libgpu/shared_device_buffer.h>
+
+namespace ocl {
+
+// Runs an element-wise kernel over host arrays of any size (also larger than the device memory) tile by tile.
+// The kernel is called as kernel(in_0, ..., out_0, ..., args..., unsigned int n) for every tile of n elements,
+// element i of every array is processed by work item i. Tiles rotate over nslots sets of device buffers, so with three slots
+// the upload of tile i+1, the kernel on tile i and the download of tile i-1 run concurrently on separate queues.
+// Transfers overlap only with pinned host memory (see gpu::shared_host_buffer), paged memory is staged by the driver.
+class StreamingExecutor {
+public:
+	typedef OpenCLKernel::Arg Arg;
+
+	// tile_size is in elements, 0 means the biggest tile such that all slots take up to a quarter of the device memory
+	StreamingExecutor(size_t tile_size = 0, size_t nslots = 3);
+
+	// Arrays are bound in the order of kernel parameters: all inputs first, then all outputs
+	StreamingExecutor &	input(const void *data, size_t element_size);
+	StreamingExecutor &	output(void *data, size_t element_size);
+
+	template <typename T>
+	StreamingExecutor &	input(const T *data)		{ return input(data, sizeof(T));	}
+	template <typename T>
+	StreamingExecutor &	output(T *data)				{ return output(data, sizeof(T));	}
+
+	// Blocks until all n elements are processed, args are passed after the arrays and before the number of elements in the tile
+	template <typename... Args>
+	void				exec(KernelSource &kernel, size_t n, unsigned int group_size, const Args &... args)
+	{
+		OpenCLKernelArgs<Args...> list(args...);
+		execArray(kernel, n, group_size, list.data(), list.size());
+	}
+
+	void				execArray(KernelSource &kernel, size_t n, unsigned int group_size, const Arg *args, size_t nargs);
+
+	// Forgets bound arrays and releases device buffers
+	void				clear();
+
+	size_t				tileSize(unsigned int group_size) const;
+
+protected:
+	struct Array {
+		Array(void *data, size_t element_size) : data(data), element_size(element_size) {}
+
+		void *			data;
+		size_t			element_size;
+	};
+
+	struct Slot {
+		std::vector<gpu::shared_device_buffer>	inputs;
+		std::vector<gpu::shared_device_buffer>	outputs;
+		OpenCLEvent								kernel;		// last kernel that used the slot
+		std::vector<OpenCLEvent>				downloads;	// last downloads from the slot
+	};
+
+	void				allocate(size_t tile_size);
+
+	sh_ptr_ocl_engine	engine_;
+	size_t				tile_size_;
+	std::vector<Array>	inputs_;
+	std::vector<Array>	outputs_;
+	std::vector<Slot>	slots_;
+	size_t				allocated_tile_size_;
+};
+
+}
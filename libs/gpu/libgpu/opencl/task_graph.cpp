@@ -0,0 +1,121 @@
+#include "task_graph.h"
+
+#include <set>
+#include <algorithm>
+#include <libgpu/context.h>
+
+namespace ocl {
+
+TaskGraph::TaskGraph(const std::string &queue_name)
+{
+	gpu::Context context;
+	GPU_CHECKED_VERBOSE(context.type() == gpu::Context::TypeOpenCL, "Task graph requires OpenCL context!");
+
+	engine_	= context.cl();
+	stream_	= engine_->stream(queue_name, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+}
+
+OpenCLStream TaskGraph::dependencies(const Access &access)
+{
+	// kernels and transfers are enqueued by the engine of the current context, while the queue belongs to engine_
+	gpu::Context context;
+	GPU_CHECKED_VERBOSE(context.type() == gpu::Context::TypeOpenCL && context.cl() == engine_, "Task graph must be used with the OpenCL context it was created in!");
+
+	std::vector<OpenCLEvent> deps;
+
+	for (size_t i = 0; i < access.reads.size(); ++i) {
+		std::map<cl_mem, BufferState>::const_iterator it = buffers_.find(access.reads[i].clmem());
+		if (it != buffers_.end())
+			deps.push_back(it->second.last_write);
+	}
+
+	for (size_t i = 0; i < access.writes.size(); ++i) {
+		std::map<cl_mem, BufferState>::const_iterator it = buffers_.find(access.writes[i].clmem());
+		if (it != buffers_.end()) {
+			deps.push_back(it->second.last_write);
+			deps.insert(deps.end(), it->second.reads_since_write.begin(), it->second.reads_since_write.end());
+		}
+	}
+
+	std::vector<OpenCLEvent> unique_deps;
+	std::set<cl_event> seen;
+	for (size_t i = 0; i < deps.size(); ++i) {
+		if (!deps[i].isNull() && seen.insert(deps[i].event()).second)
+			unique_deps.push_back(deps[i]);
+	}
+
+	return stream_.after(unique_deps);
+}
+
+void TaskGraph::commit(const Access &access, const OpenCLEvent &event)
+{
+	if (event.isNull())
+		return;
+
+	for (size_t i = 0; i < access.reads.size(); ++i) {
+		BufferState &state = buffers_[access.reads[i].clmem()];
+		state.buffer = access.reads[i];
+		state.reads_since_write.push_back(event);
+	}
+
+	for (size_t i = 0; i < access.writes.size(); ++i) {
+		BufferState &state = buffers_[access.writes[i].clmem()];
+		state.buffer = access.writes[i];
+		state.last_write = event;
+		state.reads_since_write.clear();
+	}
+
+	events_.push_back(event);
+}
+
+OpenCLEvent TaskGraph::execArray(KernelSource &kernel, const Access &access, const gpu::WorkSize &ws, const Arg *args, size_t nargs)
+{
+	OpenCLEvent event = kernel.execAsyncArray(dependencies(access), ws, args, nargs);
+	commit(access, event);
+	return event;
+}
+
+OpenCLEvent TaskGraph::write(gpu::shared_device_buffer &dst, const void *data, size_t size)
+{
+	Access access;
+	access.write(dst);
+
+	OpenCLEvent event = dst.writeAsync(data, size, dependencies(access));
+	commit(access, event);
+	return event;
+}
+
+OpenCLEvent TaskGraph::read(const gpu::shared_device_buffer &src, void *data, size_t size)
+{
+	Access access;
+	access.read(src);
+
+	OpenCLEvent event = src.readAsync(data, size, 0, dependencies(access));
+	commit(access, event);
+	return event;
+}
+
+OpenCLEvent TaskGraph::copy(const gpu::shared_device_buffer &src, gpu::shared_device_buffer &dst, size_t size)
+{
+	if (size > src.size() || size > dst.size())
+		throw gpu::gpu_exception("Not enough data in device buffers: " + to_string(size) + " > " + to_string(std::min(src.size(), dst.size())));
+
+	Access access;
+	access.read(src).write(dst);
+
+	OpenCLEvent event = engine_->copyBufferAsync(src.clmem(), dst.clmem(), src.cloffset(), dst.cloffset(), size, dependencies(access));
+	commit(access, event);
+	return event;
+}
+
+void TaskGraph::wait()
+{
+	std::vector<OpenCLEvent> events;
+	events.swap(events_);
+	buffers_.clear();
+
+	for (size_t i = 0; i < events.size(); ++i)
+		events[i].wait();
+}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include <libgpu/opencl/engine.h>
+#include <libgpu/shared_device_buffer.h>
+
+namespace ocl {
+
+// Submits kernels and transfers to an out-of-order queue, every command waits only for the commands
+// it conflicts with (read-after-write, write-after-read and write-after-write on the same buffer).
+// Buffers are tracked as a whole, so offset views of one buffer are treated as the same buffer.
+// Falls back to an in-order queue if the device does not support out-of-order execution.
+// Commands must be submitted under the OpenCL context that was active when the graph was created.
+class TaskGraph {
+public:
+	class Access {
+	public:
+		Access &	read(const gpu::shared_device_buffer &buffer)		{ reads.push_back(buffer);	return *this;	}
+		Access &	write(const gpu::shared_device_buffer &buffer)		{ writes.push_back(buffer);	return *this;	}
+
+		std::vector<gpu::shared_device_buffer>	reads;
+		std::vector<gpu::shared_device_buffer>	writes;
+	};
+
+	TaskGraph(const std::string &queue_name = "task_graph");
+
+	typedef OpenCLKernel::Arg Arg;
+
+	template <typename... Args>
+	OpenCLEvent exec(KernelSource &kernel, const Access &access, const gpu::WorkSize &ws, const Args &... args)
+	{
+		OpenCLKernelArgs<Args...> list(args...);
+		return execArray(kernel, access, ws, list.data(), list.size());
+	}
+
+	OpenCLEvent	execArray(KernelSource &kernel, const Access &access, const gpu::WorkSize &ws, const Arg *args, size_t nargs);
+
+	OpenCLEvent	write(gpu::shared_device_buffer &dst, const void *data, size_t size);
+	OpenCLEvent	read(const gpu::shared_device_buffer &src, void *data, size_t size);
+	OpenCLEvent	copy(const gpu::shared_device_buffer &src, gpu::shared_device_buffer &dst, size_t size);
+
+	// Waits for all submitted commands, throws the first execution error
+	void		wait();
+
+protected:
+	struct BufferState {
+		gpu::shared_device_buffer	buffer;		// keeps buffer alive while commands are in flight
+		OpenCLEvent					last_write;
+		std::vector<OpenCLEvent>	reads_since_write;
+	};
+
+	OpenCLStream	dependencies(const Access &access);
+	void			commit(const Access &access, const OpenCLEvent &event);
+
+	sh_ptr_ocl_engine					engine_;
+	OpenCLStream						stream_;
+	std::map<cl_mem, BufferState>		buffers_;
+	std::vector<OpenCLEvent>			events_;
+};
+
+}
@@ -10,6 +10,10 @@ namespace ocl {
 
 #define CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE	0x11B3  // since OpenCL 1.1
 
+#ifndef CL_MAP_WRITE_INVALIDATE_REGION
+#define CL_MAP_WRITE_INVALIDATE_REGION					(1 << 2)  // since OpenCL 1.2
+#endif
+
 #define CL_NV_DEVICE_ATTRIBUTE_QUERY_EXT				"cl_nv_device_attribute_query"
 #define CL_AMD_DEVICE_ATTRIBUTE_QUERY_EXT				"cl_amd_device_attribute_query"
 
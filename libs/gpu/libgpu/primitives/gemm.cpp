@@ -0,0 +1,103 @@
+#include "gemm.h"
+#include "program_cache.h"
+
+#include <libgpu/context.h>
+#include <libgpu/work_size.h>
+#include <libgpu/opencl/cl/gemm_cl.h>
+
+#include <algorithm>
+
+namespace gpu {
+
+namespace {
+
+	struct GemmConfig {
+		unsigned int	tile_size;		// of C per work group
+		unsigned int	tile_k;
+		unsigned int	work_per_item;	// along both dimensions
+
+		unsigned int	groupSide() const						{ return tile_size / work_per_item;					}
+		size_t			localMemSize(size_t type_size) const	{ return 2 * tile_k * (tile_size + 1) * type_size;	}
+	};
+
+	// From the fastest on big matrices to the most modest, the last one fits any device
+	const GemmConfig gemm_configs[] = {
+		{64, 16, 4},
+		{32, 16, 2},
+		{32, 16, 4},
+		{16, 16, 2},
+		{16, 8, 4},
+		{8, 8, 2},
+		{1, 1, 1},
+	};
+
+	bool fits(const GemmConfig &config, const ocl::sh_ptr_ocl_engine &cl, size_t type_size)
+	{
+		unsigned int side = config.groupSide();
+		return side * side <= cl->maxWorkgroupSize()
+			&& side <= cl->maxWorkItemSizes(0) && side <= cl->maxWorkItemSizes(1)
+			&& config.localMemSize(type_size) <= cl->localMemSize();
+	}
+
+	const GemmConfig &chooseConfig(const ocl::sh_ptr_ocl_engine &cl, size_t type_size, unsigned int m, unsigned int n)
+	{
+		const size_t nconfigs = sizeof(gemm_configs) / sizeof(gemm_configs[0]);
+
+		size_t best = 0;
+		while (best + 1 < nconfigs && !fits(gemm_configs[best], cl, type_size))
+			++best;
+
+		// smaller tiles for small matrices, so that all compute units get work groups
+		for (size_t i = best + 1; i < nconfigs; ++i) {
+			const GemmConfig &config = gemm_configs[best];
+			size_t ngroups = (size_t) gpu::divup(m, config.tile_size) * gpu::divup(n, config.tile_size);
+			if (ngroups >= cl->maxComputeUnits())
+				break;
+			if (fits(gemm_configs[i], cl, type_size) && gemm_configs[i].tile_size < config.tile_size)
+				best = i;
+		}
+
+		return gemm_configs[best];
+	}
+
+}
+
+template <typename T>
+void gemm(const shared_device_buffer_typed<T> &a, const shared_device_buffer_typed<T> &b, shared_device_buffer_typed<T> &c,
+		  unsigned int m, unsigned int n, unsigned int k, T alpha, T beta, GemmOp op_a, GemmOp op_b)
+{
+	if (m == 0 || n == 0)
+		return;
+	if ((size_t) m * k > a.number() || (size_t) k * n > b.number() || (size_t) m * n > c.number())
+		throw gpu_exception("Not enough elements for " + to_string(m) + "x" + to_string(k) + " by " + to_string(k) + "x" + to_string(n) + " matrix multiplication!");
+
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("GEMM requires OpenCL context!");
+	ocl::sh_ptr_ocl_engine cl = context.cl();
+
+	const GemmConfig &config = chooseConfig(cl, sizeof(T), m, n);
+
+	std::string defines = typeDefines<T>()
+						  + " -D TILE_SIZE=" + to_string(config.tile_size)
+						  + " -D TILE_K=" + to_string(config.tile_k)
+						  + " -D WORK_PER_ITEM=" + to_string(config.work_per_item)
+						  + " -D TRANSPOSE_A=" + to_string(op_a == GemmTransposed ? 1 : 0)
+						  + " -D TRANSPOSE_B=" + to_string(op_b == GemmTransposed ? 1 : 0);
+	std::shared_ptr<ocl::KernelSource> kernel = primitiveKernel(gemm_kernel, gemm_kernel_length, "gemm", defines);
+
+	unsigned int side = config.groupSide();
+	const shared_device_buffer &a_any = a;
+	const shared_device_buffer &b_any = b;
+	const shared_device_buffer &c_any = c;
+
+	kernel->exec(WorkSize(side, side, gpu::divup(n, config.tile_size) * side, gpu::divup(m, config.tile_size) * side),
+				 a_any, b_any, c_any, m, n, k, alpha, beta);
+}
+
+template void gemm<float>(const shared_device_buffer_typed<float> &a, const shared_device_buffer_typed<float> &b, shared_device_buffer_typed<float> &c,
+						  unsigned int m, unsigned int n, unsigned int k, float alpha, float beta, GemmOp op_a, GemmOp op_b);
+template void gemm<double>(const shared_device_buffer_typed<double> &a, const shared_device_buffer_typed<double> &b, shared_device_buffer_typed<double> &c,
+						   unsigned int m, unsigned int n, unsigned int k, double alpha, double beta, GemmOp op_a, GemmOp op_b);
+
+}
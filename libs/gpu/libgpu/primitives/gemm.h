@@ -0,0 +1,20 @@
+#pragma once
+
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+enum GemmOp {
+	GemmNormal,
+	GemmTransposed,
+};
+
+// C = alpha * op(A) * op(B) + beta * C on the device of the current OpenCL context, where op(A) is m x k and op(B) is k x n.
+// All matrices are row-major: A is stored as m x k (k x m if op_a is GemmTransposed), B as k x n (n x k if op_b is GemmTransposed).
+// C is not read if beta is zero. Tile sizes are chosen from the local memory size and the max work group size of the device.
+// T is float or double (double requires cl_khr_fp64)
+template <typename T>
+void gemm(const shared_device_buffer_typed<T> &a, const shared_device_buffer_typed<T> &b, shared_device_buffer_typed<T> &c,
+		  unsigned int m, unsigned int n, unsigned int k, T alpha = 1, T beta = 0, GemmOp op_a = GemmNormal, GemmOp op_b = GemmNormal);
+
+}
@@ -0,0 +1,86 @@
+#include "gemm_batched.h"
+#include "program_cache.h"
+
+#include <libgpu/context.h>
+#include <libgpu/work_size.h>
+#include <libgpu/opencl/cl/gemm_batched_cl.h>
+
+#include <algorithm>
+
+namespace gpu {
+
+namespace {
+
+	const unsigned int gemm_batched_max_size		= 64;
+	const unsigned int gemm_batched_group_size		= 256;
+	const unsigned int gemm_batched_groups_per_unit	= 8;	// work groups per compute unit, each of them walks over the batch
+
+	void checkSize(size_t size, size_t stride, unsigned int batch, size_t number, const std::string &name)
+	{
+		size_t required = (batch - 1) * stride + size;
+		if (required > number)
+			throw gpu_exception("Not enough elements in " + name + " for the batched matrix multiplication: " + to_string(required) + " > " + to_string(number));
+	}
+
+}
+
+template <typename T>
+void gemmStridedBatched(const shared_device_buffer_typed<T> &a, unsigned int stride_a,
+						const shared_device_buffer_typed<T> &b, unsigned int stride_b,
+						shared_device_buffer_typed<T> &c, unsigned int stride_c,
+						unsigned int m, unsigned int n, unsigned int k, unsigned int batch, T alpha, T beta)
+{
+	if (batch == 0)
+		return;
+	if (m == 0 || n == 0 || k == 0 || m > gemm_batched_max_size || n > gemm_batched_max_size || k > gemm_batched_max_size)
+		throw gpu_exception("Unsupported size of the batched matrix multiplication: " + to_string(m) + "x" + to_string(k) + " by " + to_string(k) + "x" + to_string(n) + "!");
+	if (batch > 1 && stride_c < m * n)
+		throw gpu_exception("Matrices of C overlap: stride " + to_string(stride_c) + " < " + to_string(m * n));
+
+	checkSize(m * k, stride_a, batch, a.number(), "A");
+	checkSize(k * n, stride_b, batch, b.number(), "B");
+	checkSize(m * n, stride_c, batch, c.number(), "C");
+
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("Batched GEMM requires OpenCL context!");
+	ocl::sh_ptr_ocl_engine cl = context.cl();
+
+	unsigned int group_size = gemm_batched_group_size;
+	while (group_size > 1 && group_size > cl->maxWorkgroupSize())
+		group_size /= 2;
+
+	// about four results per work item, as many matrices as fit into a half of local memory
+	size_t matrix_size = (m * k + k * n) * sizeof(T);
+	size_t local_mem = cl->localMemSize() / 2;
+	unsigned int matrices_per_step = std::max(4 * group_size / (m * n), 1u);
+	while (matrices_per_step > 1 && matrices_per_step * matrix_size > local_mem)
+		matrices_per_step /= 2;
+	bool use_local = matrices_per_step * matrix_size <= local_mem;
+
+	std::string defines = typeDefines<T>()
+						  + " -D M=" + to_string(m) + " -D N=" + to_string(n) + " -D K=" + to_string(k)
+						  + " -D GROUP_SIZE=" + to_string(group_size)
+						  + " -D MATRICES_PER_STEP=" + to_string(matrices_per_step)
+						  + " -D USE_LOCAL=" + to_string(use_local ? 1 : 0);
+	std::shared_ptr<ocl::KernelSource> kernel = primitiveKernel(gemm_batched_kernel, gemm_batched_kernel_length, "gemm_batched", defines);
+
+	size_t ngroups = std::min((size_t) gpu::divup(batch, matrices_per_step), cl->maxComputeUnits() * gemm_batched_groups_per_unit);
+	const shared_device_buffer &a_any = a;
+	const shared_device_buffer &b_any = b;
+	const shared_device_buffer &c_any = c;
+
+	kernel->exec(WorkSize(group_size, (unsigned int) ngroups * group_size),
+				 a_any, b_any, c_any, stride_a, stride_b, stride_c, batch, alpha, beta);
+}
+
+#define GEMM_BATCHED_INSTANTIATE(T) \
+	template void gemmStridedBatched<T>(const shared_device_buffer_typed<T> &a, unsigned int stride_a, \
+										const shared_device_buffer_typed<T> &b, unsigned int stride_b, \
+										shared_device_buffer_typed<T> &c, unsigned int stride_c, \
+										unsigned int m, unsigned int n, unsigned int k, unsigned int batch, T alpha, T beta);
+
+GEMM_BATCHED_INSTANTIATE(float)
+GEMM_BATCHED_INSTANTIATE(double)
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// C[i] = alpha * A[i] * B[i] + beta * C[i] for i < batch on the device of the current OpenCL context, in one launch.
+// A[i] (m x k), B[i] (k x n) and C[i] (m x n) are row-major and start at i * stride_a, i * stride_b and i * stride_c elements,
+// e.g. stride_a = 0 multiplies the same A by all B[i]. Sizes are from 1 to 64 (use gpu::gemm for bigger matrices),
+// a kernel is compiled for every combination of them. C is not read if beta is zero.
+// T is float or double (double requires cl_khr_fp64)
+template <typename T>
+void gemmStridedBatched(const shared_device_buffer_typed<T> &a, unsigned int stride_a,
+						const shared_device_buffer_typed<T> &b, unsigned int stride_b,
+						shared_device_buffer_typed<T> &c, unsigned int stride_c,
+						unsigned int m, unsigned int n, unsigned int k, unsigned int batch, T alpha = 1, T beta = 0);
+
+}
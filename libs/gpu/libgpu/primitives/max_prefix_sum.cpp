@@ -0,0 +1,124 @@
+#include "max_prefix_sum.h"
+#include "program_cache.h"
+
+#include <libgpu/context.h>
+#include <libgpu/work_size.h>
+#include <libgpu/opencl/cl/max_prefix_sum_cl.h>
+
+#include <limits>
+#include <algorithm>
+
+namespace gpu {
+
+namespace {
+
+	const unsigned int max_prefix_sum_max_group_size			= 256;
+	const unsigned int max_prefix_sum_items_per_work_item		= 4;	// ITEMS_PER_WORK_ITEM in max_prefix_sum.cl
+
+	// a few groups per compute unit load the device, the merge pass takes at most one range per work item
+	const unsigned int max_groups_per_compute_unit				= 8;
+
+}
+
+template <typename T>
+void MaxPrefixSum<T>::append(const MaxPrefixSum<T> &other)
+{
+	if (other.count == 0)
+		return;
+
+	if (count == 0 || sum + other.max_prefix > max_prefix) {
+		max_prefix	= sum + other.max_prefix;
+		index		= count + other.index;
+	}
+	sum		+= other.sum;
+	count	+= other.count;
+}
+
+template <typename T>
+MaxPrefixSum<T> maxPrefixSum(const shared_device_buffer_typed<T> &as, unsigned int n)
+{
+	MaxPrefixSum<T> res;
+	if (n == 0)
+		return res;
+	if (n > as.number())
+		throw gpu_exception("Not enough elements: " + to_string(n) + " > " + to_string(as.number()));
+
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("Maximum prefix sum requires OpenCL context!");
+	ocl::sh_ptr_ocl_engine cl = context.cl();
+
+	unsigned int group_size = max_prefix_sum_max_group_size;
+	while (group_size > 1 && group_size > cl->maxWorkgroupSize())
+		group_size /= 2;
+	unsigned int tile_size = group_size * max_prefix_sum_items_per_work_item;
+
+	std::string defines = typeDefines<T>() + " -D GROUP_SIZE=" + to_string(group_size);
+	std::shared_ptr<ocl::KernelSource> ranges	= primitiveKernel(max_prefix_sum_kernel, max_prefix_sum_kernel_length, "max_prefix_sum", defines);
+	std::shared_ptr<ocl::KernelSource> merge	= primitiveKernel(max_prefix_sum_kernel, max_prefix_sum_kernel_length, "max_prefix_sum_merge", defines);
+
+	unsigned int ntiles = gpu::divup(n, tile_size);
+	size_t max_groups = std::min(std::max(cl->maxComputeUnits(), (size_t) 1) * max_groups_per_compute_unit, (size_t) group_size);
+	unsigned int tiles_per_group = gpu::divup(ntiles, (unsigned int) std::min((size_t) ntiles, max_groups));
+	unsigned int ngroups = gpu::divup(ntiles, tiles_per_group);
+
+	shared_device_buffer_typed<T> sums = shared_device_buffer_typed<T>::createN(ngroups);
+	shared_device_buffer_typed<T> max_prefixes = shared_device_buffer_typed<T>::createN(ngroups);
+	gpu_mem_32u indices = gpu_mem_32u::createN(ngroups);
+
+	const shared_device_buffer &src = as;
+	const shared_device_buffer &sums_any = sums;
+	const shared_device_buffer &max_prefixes_any = max_prefixes;
+
+	ranges->execAsync(WorkSize(group_size, ngroups * group_size),
+					  src, n, tiles_per_group, sums_any, max_prefixes_any, indices);
+	if (ngroups > 1)
+		merge->execAsync(WorkSize(group_size, group_size), sums_any, max_prefixes_any, indices, ngroups);
+
+	unsigned int index = 0;
+	sums.readN(&res.sum, 1);
+	max_prefixes.readN(&res.max_prefix, 1);
+	indices.readN(&index, 1);
+
+	res.index = index;
+	res.count = n;
+	return res;
+}
+
+template <typename T>
+void MaxPrefixSumStream<T>::append(const shared_device_buffer_typed<T> &chunk, unsigned int n)
+{
+	state_.append(maxPrefixSum(chunk, n));
+}
+
+template <typename T>
+void MaxPrefixSumStream<T>::append(const T *chunk, size_t n)
+{
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("Maximum prefix sum requires OpenCL context!");
+
+	size_t max_part = std::min(context.cl()->maxMemAllocSize() / sizeof(T), (size_t) std::numeric_limits<unsigned int>::max());
+	if (max_part_)
+		max_part = std::min(max_part, max_part_);
+
+	for (size_t offset = 0; offset < n; offset += max_part) {
+		unsigned int part = (unsigned int) std::min(max_part, n - offset);
+		if (buffer_.number() < part)
+			buffer_.resizeN(part);
+
+		buffer_.writeN(chunk + offset, part);
+		append(buffer_, part);
+	}
+}
+
+#define MAX_PREFIX_SUM_INSTANTIATE(T) \
+	template struct MaxPrefixSum<T>; \
+	template MaxPrefixSum<T> maxPrefixSum<T>(const shared_device_buffer_typed<T> &as, unsigned int n); \
+	template class MaxPrefixSumStream<T>;
+
+MAX_PREFIX_SUM_INSTANTIATE(int32_t)
+MAX_PREFIX_SUM_INSTANTIATE(float)
+MAX_PREFIX_SUM_INSTANTIATE(double)
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+template <typename T>
+struct MaxPrefixSum {
+	MaxPrefixSum() : sum(0), max_prefix(0), index(0), count(0) {}
+
+	T					sum;			// of all elements
+	T					max_prefix;		// maximum sum of a non-empty prefix
+	unsigned long long	index;			// of the last element of the first prefix with max_prefix
+	unsigned long long	count;			// of elements, max_prefix and index are undefined if it is 0
+
+	// Appends the series described by other (its index is relative to its own start)
+	void				append(const MaxPrefixSum<T> &other);
+};
+
+// Maximum prefix sum of the first n elements on the device of the current OpenCL context: a pass of many work groups over
+// consecutive ranges and a merge of their (sum, max_prefix, index) by a single group, only the merged tuple is read back.
+// T is int32_t, float or double (double requires cl_khr_fp64)
+template <typename T>
+MaxPrefixSum<T> maxPrefixSum(const shared_device_buffer_typed<T> &as, unsigned int n);
+
+// Maximum prefix sum of a series processed chunk by chunk, e.g. larger than the device memory or arriving over time
+template <typename T>
+class MaxPrefixSumStream {
+public:
+	// Host chunks are uploaded by parts of up to max_part elements, 0 means as many as fit into one allocation
+	explicit MaxPrefixSumStream(size_t max_part = 0) : max_part_(max_part) {}
+
+	// Chunks continue the series
+	void					append(const shared_device_buffer_typed<T> &chunk, unsigned int n);
+	// Uploaded through a device buffer kept between calls, split into parts if needed
+	void					append(const T *chunk, size_t n);
+
+	const MaxPrefixSum<T> &	result() const	{ return state_;			}
+	void					reset()			{ state_ = MaxPrefixSum<T>();	}
+
+protected:
+	size_t							max_part_;
+	MaxPrefixSum<T>					state_;
+	shared_device_buffer_typed<T>	buffer_;
+};
+
+}
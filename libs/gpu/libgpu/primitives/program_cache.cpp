@@ -0,0 +1,68 @@
+#include "program_cache.h"
+
+#include <libgpu/context.h>
+#include <libutils/thread_mutex.h>
+
+#include <map>
+#include <type_traits>
+
+namespace gpu {
+
+namespace {
+
+	struct Specialization {
+		std::string											source;		// ProgramBinaries doesn't copy it
+		std::shared_ptr<ocl::ProgramBinaries>				program;
+		std::map<std::string, std::shared_ptr<ocl::KernelSource> >	kernels;
+	};
+
+	Mutex											specializations_mutex;
+	std::map<std::string, Specialization *>			specializations;
+
+}
+
+std::shared_ptr<ocl::KernelSource> primitiveKernel(const char *source, size_t source_length, const std::string &kernel_name,
+												   const std::string &defines, const std::string &preamble)
+{
+	// the same embedded array is the same program
+	std::string key = to_string((const void *) source) + "\n" + defines + "\n" + preamble;
+
+	Lock lock(specializations_mutex);
+
+	Specialization *&specialization = specializations[key];
+	if (!specialization) {
+		// never freed: kernels are owned by engines which may outlive any other owner
+		specialization = new Specialization;
+		specialization->source	= preamble + std::string(source, source_length);
+		specialization->program	= std::make_shared<ocl::ProgramBinaries>(specialization->source.data(), specialization->source.size(), defines);
+	}
+
+	std::shared_ptr<ocl::KernelSource> &kernel = specialization->kernels[kernel_name];
+	if (!kernel)
+		kernel = std::make_shared<ocl::KernelSource>(specialization->program, kernel_name);
+
+	return kernel;
+}
+
+template <typename T>
+std::string typeDefines(const std::string &macro)
+{
+	if (std::is_same<T, double>::value) {
+		Context context;
+		if (context.type() == Context::TypeOpenCL && context.cl()->deviceInfo().extensions.count("cl_khr_fp64") == 0)
+			throw gpu_exception("Double precision is not supported by the device!");
+	}
+
+	return "-D " + macro + "=" + ocl::OpenCLType<T>::name();
+}
+
+template std::string typeDefines<int8_t>(const std::string &macro);
+template std::string typeDefines<int16_t>(const std::string &macro);
+template std::string typeDefines<int32_t>(const std::string &macro);
+template std::string typeDefines<uint8_t>(const std::string &macro);
+template std::string typeDefines<uint16_t>(const std::string &macro);
+template std::string typeDefines<uint32_t>(const std::string &macro);
+template std::string typeDefines<float>(const std::string &macro);
+template std::string typeDefines<double>(const std::string &macro);
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <libgpu/opencl/engine.h>
+
+namespace gpu {
+
+// Kernel of an embedded program (see convertIntoHeader) specialized by ProgramBinaries defines and by a preamble prepended
+// to the source (for macros which can't be passed as -D options, e.g. function-like ones). Programs are built once per
+// specialization and device for the whole process, so primitives can request their kernels on every call.
+std::shared_ptr<ocl::KernelSource> primitiveKernel(const char *source, size_t source_length, const std::string &kernel_name,
+												   const std::string &defines, const std::string &preamble = std::string());
+
+// -D options for an element type, e.g. "-D T=float", with cl_khr_fp64 checked for double
+template <typename T>
+std::string typeDefines(const std::string &macro = "T");
+
+}
@@ -0,0 +1,100 @@
+#include "reduce.h"
+#include "program_cache.h"
+
+#include <libgpu/context.h>
+#include <libgpu/work_size.h>
+#include <libgpu/opencl/cl/reduce_cl.h>
+
+#include <limits>
+#include <algorithm>
+
+namespace gpu {
+
+namespace {
+
+	// partial results of the first pass are reduced by one group, so a few groups per compute unit are enough to load the device
+	const unsigned int max_groups_per_compute_unit = 8;
+
+	unsigned int reduceGroupSize(const ocl::sh_ptr_ocl_engine &cl)
+	{
+		unsigned int group_size = 256;
+		while (group_size > 1 && group_size > cl->maxWorkgroupSize())
+			group_size /= 2;
+		return group_size;
+	}
+
+}
+
+template <typename T>
+T reduce(const shared_device_buffer_typed<T> &as, unsigned int n, const std::string &op, T identity)
+{
+	if (n == 0)
+		return identity;
+	if (n > as.number())
+		throw gpu_exception("Not enough elements to reduce: " + to_string(n) + " > " + to_string(as.number()));
+
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("Reduction requires OpenCL context!");
+	ocl::sh_ptr_ocl_engine cl = context.cl();
+
+	unsigned int group_size = reduceGroupSize(cl);
+	std::string defines = typeDefines<T>() + " -D GROUP_SIZE=" + to_string(group_size);
+	std::shared_ptr<ocl::KernelSource> kernel = primitiveKernel(reduce_kernel, reduce_kernel_length, "reduce", defines,
+																"#define OP(a, b) (" + op + ")\n");
+
+	size_t max_groups = std::max(cl->maxComputeUnits(), (size_t) 1) * max_groups_per_compute_unit;
+	// the final pass alone is enough if there are few elements
+	unsigned int ngroups = (unsigned int) std::min((size_t) gpu::divup(n, group_size), std::min(max_groups, (size_t) group_size));
+
+	shared_device_buffer_typed<T> partial = shared_device_buffer_typed<T>::createN(ngroups);
+	const shared_device_buffer &src = as;
+	const shared_device_buffer &dst = partial;
+
+	if (ngroups > 1) {
+		kernel->execAsync(WorkSize(group_size, ngroups * group_size), src, dst, n, identity);
+
+		shared_device_buffer_typed<T> result = shared_device_buffer_typed<T>::createN(1);
+		kernel->exec(WorkSize(group_size, group_size), dst, (const shared_device_buffer &) result, ngroups, identity);
+
+		T res;
+		result.readN(&res, 1);
+		return res;
+	}
+
+	kernel->exec(WorkSize(group_size, group_size), src, dst, n, identity);
+
+	T res;
+	partial.readN(&res, 1);
+	return res;
+}
+
+template <typename T>
+T reduce(const shared_device_buffer_typed<T> &as, unsigned int n, ReduceOp op)
+{
+	switch (op) {
+	case ReduceSum:
+		return reduce<T>(as, n, "a + b", (T) 0);
+	case ReduceMin:
+		return reduce<T>(as, n, "min(a, b)", (T) (std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max()));
+	case ReduceMax:
+		return reduce<T>(as, n, "max(a, b)", (T) (std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest()));
+	}
+
+	throw gpu_exception("Unknown reduce operation: " + to_string((int) op));
+}
+
+#define REDUCE_INSTANTIATE(T) \
+	template T reduce<T>(const shared_device_buffer_typed<T> &as, unsigned int n, ReduceOp op); \
+	template T reduce<T>(const shared_device_buffer_typed<T> &as, unsigned int n, const std::string &op, T identity);
+
+REDUCE_INSTANTIATE(int8_t)
+REDUCE_INSTANTIATE(int16_t)
+REDUCE_INSTANTIATE(int32_t)
+REDUCE_INSTANTIATE(uint8_t)
+REDUCE_INSTANTIATE(uint16_t)
+REDUCE_INSTANTIATE(uint32_t)
+REDUCE_INSTANTIATE(float)
+REDUCE_INSTANTIATE(double)
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+enum ReduceOp {
+	ReduceSum,
+	ReduceMin,
+	ReduceMax,
+};
+
+// Reduction of the first n elements on the device of the current OpenCL context: a pass of many work groups into partial
+// results and a final pass of a single work group, only the scalar result is read back. T is any ocl::OpenCLType
+// (double requires cl_khr_fp64), sums of integers wrap around in T. Returns the identity of op for n = 0
+template <typename T>
+T reduce(const shared_device_buffer_typed<T> &as, unsigned int n, ReduceOp op = ReduceSum);
+
+// op is an associative and commutative OpenCL C expression of a and b, identity is its neutral element,
+// e.g. reduce(as, n, "a * b", 1.0f) or reduce(as, n, "max(fabs(a), fabs(b))", 0.0f)
+template <typename T>
+T reduce(const shared_device_buffer_typed<T> &as, unsigned int n, const std::string &op, T identity);
+
+}
@@ -0,0 +1,79 @@
+#include "scan.h"
+#include "program_cache.h"
+
+#include <libgpu/context.h>
+#include <libgpu/work_size.h>
+#include <libgpu/opencl/cl/scan_cl.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace gpu {
+
+namespace {
+
+	const unsigned int scan_max_group_size		= 256;
+	const unsigned int scan_items_per_work_item	= 4;	// ITEMS_PER_WORK_ITEM in scan.cl
+
+	struct ScanKernels {
+		std::shared_ptr<ocl::KernelSource>	block_sums;
+		std::shared_ptr<ocl::KernelSource>	blocks;
+		unsigned int						group_size;
+		unsigned int						block_size;
+	};
+
+	// Returns the event of the last launch, the queue is in-order so all previous ones are finished with it.
+	// Block sums of all levels are kept in temps until then, so the pool doesn't hand them out while they are in use
+	template <typename T>
+	ocl::OpenCLEvent scanLevel(const ScanKernels &kernels, const shared_device_buffer &as, const shared_device_buffer &res, unsigned int n, bool exclusive,
+							   std::vector<shared_device_buffer> &temps)
+	{
+		unsigned int nblocks = gpu::divup(n, kernels.block_size);
+		WorkSize ws(kernels.group_size, nblocks * kernels.group_size);
+
+		if (nblocks == 1) {
+			return kernels.blocks->execAsync(ws, as, res, res, n, (unsigned int) exclusive, 0u);
+		}
+
+		temps.push_back(shared_device_buffer_typed<T>::createN(nblocks));
+		const shared_device_buffer sums = temps.back();
+
+		kernels.block_sums->execAsync(ws, as, sums, n);
+		scanLevel<T>(kernels, sums, sums, nblocks, true, temps);
+		return kernels.blocks->execAsync(ws, as, res, sums, n, (unsigned int) exclusive, 1u);
+	}
+
+}
+
+template <typename T>
+void scan(const shared_device_buffer_typed<T> &as, shared_device_buffer_typed<T> &res, unsigned int n, ScanType type)
+{
+	if (n == 0)
+		return;
+	if (n > as.number() || n > res.number())
+		throw gpu_exception("Not enough elements to scan: " + to_string(n) + " > " + to_string(std::min(as.number(), res.number())));
+
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("Scan requires OpenCL context!");
+	ocl::sh_ptr_ocl_engine cl = context.cl();
+
+	ScanKernels kernels;
+	kernels.group_size = scan_max_group_size;
+	while (kernels.group_size > 1 && kernels.group_size > cl->maxWorkgroupSize())
+		kernels.group_size /= 2;
+	kernels.block_size = kernels.group_size * scan_items_per_work_item;
+
+	std::string defines = typeDefines<T>() + " -D GROUP_SIZE=" + to_string(kernels.group_size);
+	kernels.block_sums	= primitiveKernel(scan_kernel, scan_kernel_length, "scan_block_sums", defines);
+	kernels.blocks		= primitiveKernel(scan_kernel, scan_kernel_length, "scan_blocks", defines);
+
+	std::vector<shared_device_buffer> temps;
+	scanLevel<T>(kernels, as, res, n, type == ScanExclusive, temps).wait();
+}
+
+template void scan<int32_t>(const shared_device_buffer_typed<int32_t> &as, shared_device_buffer_typed<int32_t> &res, unsigned int n, ScanType type);
+template void scan<uint32_t>(const shared_device_buffer_typed<uint32_t> &as, shared_device_buffer_typed<uint32_t> &res, unsigned int n, ScanType type);
+template void scan<float>(const shared_device_buffer_typed<float> &as, shared_device_buffer_typed<float> &res, unsigned int n, ScanType type);
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+enum ScanType {
+	ScanInclusive,		// res[i] = as[0] + ... + as[i]
+	ScanExclusive,		// res[i] = as[0] + ... + as[i - 1], res[0] = 0
+};
+
+// Prefix sums of the first n elements on the device of the current OpenCL context, as and res may be the same buffer.
+// Blocks of 1024 elements (fewer if the device has smaller work groups) are scanned in local memory and their sums are scanned recursively, so every element is read twice
+// and written once. T is int32_t, uint32_t or float (float sums depend on the order of additions)
+template <typename T>
+void scan(const shared_device_buffer_typed<T> &as, shared_device_buffer_typed<T> &res, unsigned int n, ScanType type = ScanInclusive);
+
+}
@@ -0,0 +1,60 @@
+#include "transpose.h"
+#include "program_cache.h"
+
+#include <libgpu/context.h>
+#include <libgpu/work_size.h>
+#include <libgpu/opencl/cl/transpose_cl.h>
+
+namespace gpu {
+
+namespace {
+
+	const unsigned int transpose_tile_size = 32;
+
+}
+
+template <typename T>
+void transpose(const shared_device_buffer_typed<T> &as, shared_device_buffer_typed<T> &res, unsigned int width, unsigned int height, unsigned int batch)
+{
+	size_t n = (size_t) width * height * batch;
+	if (n == 0)
+		return;
+	if (n > as.number() || n > res.number())
+		throw gpu_exception("Not enough elements to transpose: " + to_string(n) + " > " + to_string(std::min(as.number(), res.number())));
+	if (as.clmem() == res.clmem() && as.cloffset() == res.cloffset())
+		throw gpu_exception("Transpose can't be done in place!");
+
+	Context context;
+	if (context.type() != Context::TypeOpenCL)
+		throw gpu_exception("Transpose requires OpenCL context!");
+	ocl::sh_ptr_ocl_engine cl = context.cl();
+
+	// 32 x 8 work items if the device allows, each of them moves 4 elements of a tile
+	unsigned int tile_rows = 8;
+	while (tile_rows > 1 && transpose_tile_size * tile_rows > cl->maxWorkgroupSize())
+		tile_rows /= 2;
+
+	std::string defines = typeDefines<T>() + " -D TILE_SIZE=" + to_string(transpose_tile_size) + " -D TILE_ROWS=" + to_string(tile_rows);
+	std::shared_ptr<ocl::KernelSource> kernel = primitiveKernel(transpose_kernel, transpose_kernel_length, "transpose", defines);
+
+	unsigned int tiles_y = gpu::divup(height, transpose_tile_size);
+	const shared_device_buffer &src = as;
+	const shared_device_buffer &dst = res;
+
+	kernel->exec(WorkSize(transpose_tile_size, tile_rows, width, batch * tiles_y * tile_rows),
+				 src, dst, width, height, tiles_y);
+}
+
+#define TRANSPOSE_INSTANTIATE(T) \
+	template void transpose<T>(const shared_device_buffer_typed<T> &as, shared_device_buffer_typed<T> &res, unsigned int width, unsigned int height, unsigned int batch);
+
+TRANSPOSE_INSTANTIATE(int8_t)
+TRANSPOSE_INSTANTIATE(int16_t)
+TRANSPOSE_INSTANTIATE(int32_t)
+TRANSPOSE_INSTANTIATE(uint8_t)
+TRANSPOSE_INSTANTIATE(uint16_t)
+TRANSPOSE_INSTANTIATE(uint32_t)
+TRANSPOSE_INSTANTIATE(float)
+TRANSPOSE_INSTANTIATE(double)
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <libgpu/shared_device_buffer.h>
+
+namespace gpu {
+
+// res (width rows of height elements) = as (height rows of width elements) transposed, on the device of the current OpenCL context.
+// Both are row-major, batch matrices of the same size are stored one after another. as and res must be different buffers.
+// T is any ocl::OpenCLType (double requires cl_khr_fp64)
+template <typename T>
+void transpose(const shared_device_buffer_typed<T> &as, shared_device_buffer_typed<T> &res, unsigned int width, unsigned int height, unsigned int batch = 1);
+
+}
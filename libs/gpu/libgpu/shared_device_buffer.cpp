@@ -36,6 +36,7 @@ shared_device_buffer::shared_device_buffer(const shared_device_buffer &other, si
 	type_	= other.type_;
 	size_	= other.size_;
 	offset_	= other.offset_ + offset;
+	pool_	= other.pool_;
 	incref();
 }
 
@@ -48,6 +49,7 @@ shared_device_buffer &shared_device_buffer::operator= (const shared_device_buffe
 		type_	= other.type_;
 		size_	= other.size_;
 		offset_	= other.offset_;
+		pool_	= other.pool_;
 		incref();
 	}
 
@@ -61,6 +63,7 @@ void shared_device_buffer::swap(shared_device_buffer &other)
 	std::swap(type_,	other.type_);
 	std::swap(size_,	other.size_);
 	std::swap(offset_,	other.offset_);
+	std::swap(pool_,	other.pool_);
 }
 
 void shared_device_buffer::incref()
@@ -100,7 +103,12 @@ void shared_device_buffer::decref()
 			break;
 #endif
 		case Context::TypeOpenCL:
-			clReleaseMemObject((cl_mem) data_);
+			if (pool_) {
+				pool_->release((cl_mem) data_);
+			} else {
+				clReleaseMemObject((cl_mem) data_);
+				ocl::OpenCLKernel::invalidateMemArgs();
+			}
 			break;
 		default:
 			gpu::raiseException(__FILE__, __LINE__, "No GPU context!");
@@ -114,6 +122,7 @@ void shared_device_buffer::decref()
 	type_	= Context::TypeUndefined;
 	size_	= 0;
 	offset_	= 0;
+	pool_.reset();
 }
 
 shared_device_buffer shared_device_buffer::create(size_t size)
@@ -147,6 +156,20 @@ size_t shared_device_buffer::cloffset() const
 	return offset_;
 }
 
+cl_mem shared_device_buffer::clmemView() const
+{
+	if (offset_ == 0)
+		return clmem();
+
+	if (offset_ >= size_)
+		throw gpu_exception("Offset " + to_string(offset_) + " is out of buffer of size " + to_string(size_));
+
+	if (!pool_)
+		throw gpu_exception("Can not create sub-buffer of a buffer not allocated from OpenCL engine");
+
+	return pool_->subBuffer(clmem(), offset_, size_ - offset_);
+}
+
 size_t shared_device_buffer::size() const
 {
 	return size_;
@@ -179,7 +202,8 @@ void shared_device_buffer::resize(size_t size)
 		break;
 #endif
 	case Context::TypeOpenCL:
-		data_ = context.cl()->createBuffer(CL_MEM_READ_WRITE, size);
+		pool_ = context.cl()->bufferPool();
+		data_ = pool_->allocate(*context.cl(), CL_MEM_READ_WRITE, size);
 		break;
 	default:
 		gpu::raiseException(__FILE__, __LINE__, "No GPU context!");
@@ -194,6 +218,77 @@ void shared_device_buffer::resize(size_t size)
 	offset_	= 0;
 }
 
+static void CL_CALLBACK freeHostSharedMemory(cl_mem, void *ptr)
+{
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+void shared_device_buffer::resizeHostShared(size_t size)
+{
+	Context context;
+	if (context.type() != Context::TypeOpenCL) {
+		resize(size);
+		return;
+	}
+
+	decref();
+
+	// page alignment and cache line multiple size are required by Intel and AMD CPU runtimes for zero-copy
+	const size_t page_size = 4096;
+	const size_t cache_line = 64;
+	size_t host_size = std::max((size + cache_line - 1) / cache_line * cache_line, cache_line);
+
+	void *host_ptr = 0;
+#ifdef _WIN32
+	host_ptr = _aligned_malloc(host_size, page_size);
+#else
+	if (posix_memalign(&host_ptr, page_size, host_size) != 0)
+		host_ptr = 0;
+#endif
+	if (!host_ptr)
+		throw std::bad_alloc();
+
+	cl_int status = CL_SUCCESS;
+	cl_mem mem = clCreateBuffer(context.cl()->context(), CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, host_size, host_ptr, &status);
+	if (status != CL_SUCCESS) {
+		freeHostSharedMemory(0, host_ptr);
+		OCL_SAFE_CALL(status);
+	}
+
+	// host memory is freed when the driver destroys the buffer, i.e. after all commands using it are finished
+	if (clSetMemObjectDestructorCallback(mem, freeHostSharedMemory, host_ptr) != CL_SUCCESS) {
+		clReleaseMemObject(mem);
+		freeHostSharedMemory(0, host_ptr);
+		resize(size);
+		return;
+	}
+
+	data_	= mem;
+	pool_	= context.cl()->bufferPool();	// for sub-buffers, the buffer itself is not cached by the pool
+
+	buffer_	= new unsigned char [8];
+	* (long long *) buffer_ = 0;
+	incref();
+
+	type_	= Context::TypeOpenCL;
+	size_	= size;
+	offset_	= 0;
+}
+
+bool shared_device_buffer::isHostShared() const
+{
+	if (type_ != Context::TypeOpenCL || !data_)
+		return false;
+
+	cl_mem_flags flags = 0;
+	OCL_SAFE_CALL(clGetMemObjectInfo((cl_mem) data_, CL_MEM_FLAGS, sizeof(flags), &flags, NULL));
+	return (flags & CL_MEM_USE_HOST_PTR) != 0;
+}
+
 void shared_device_buffer::grow(size_t size, float reserveMultiplier)
 {
 	if (size > size_)
@@ -253,6 +348,8 @@ void shared_device_buffer::write(const shared_host_buffer &buffer, size_t size)
 
 	if (size > size_)
 		throw gpu_exception("Too many data for this device buffer: " + to_string(size) + " > " + to_string(size_));
+	if (size > buffer.size())
+		throw gpu_exception("Not enough data in this host buffer: " + to_string(size) + " > " + to_string(buffer.size()));
 
 	Context context;
 	switch (context.type()) {
@@ -262,6 +359,7 @@ void shared_device_buffer::write(const shared_host_buffer &buffer, size_t size)
 		break;
 #endif
 	case Context::TypeOpenCL:
+		// the mapped pointer of a CL_MEM_ALLOC_HOST_PTR buffer is recognized by the driver as page-locked
 		context.cl()->writeBuffer((cl_mem) data_, CL_TRUE, offset_, size, buffer.get());
 		break;
 	default:
@@ -318,6 +416,14 @@ void shared_device_buffer::read(void *data, size_t size, size_t offset) const
 	}
 }
 
+void shared_device_buffer::read(shared_host_buffer &buffer, size_t size, size_t offset) const
+{
+	if (size > buffer.size())
+		throw gpu_exception("Too many data for this host buffer: " + to_string(size) + " > " + to_string(buffer.size()));
+
+	read(buffer.get(), size, offset);
+}
+
 void shared_device_buffer::read2D(size_t spitch, void *dst, size_t dpitch, size_t width, size_t height) const
 {
 	if (spitch == width && dpitch == width) {
@@ -367,6 +473,92 @@ void shared_device_buffer::copyTo(shared_device_buffer &that, size_t size) const
 	}
 }
 
+void *shared_device_buffer::map(unsigned int mode, size_t size, size_t offset)
+{
+	if (offset + size > size_ - offset_)
+		throw gpu_exception("Mapped region [" + to_string(offset) + ", " + to_string(offset + size) + ") is out of buffer of size " + to_string(size_ - offset_));
+
+	Context context;
+	switch (context.type()) {
+	case Context::TypeOpenCL:
+		{
+			const ocl::DeviceInfo &info = context.cl()->deviceInfo();
+			bool invalidate_supported = info.opencl_major_version > 1 || (info.opencl_major_version == 1 && info.opencl_minor_version >= 2);
+
+			cl_map_flags flags = 0;
+			if (mode & MapRead)
+				flags |= CL_MAP_READ;
+			if (mode & MapWrite)
+				flags |= (mode & MapDiscard) && !(mode & MapRead) && invalidate_supported ? CL_MAP_WRITE_INVALIDATE_REGION : CL_MAP_WRITE;
+
+			return context.cl()->mapBuffer((cl_mem) data_, flags, offset_ + offset, size);
+		}
+	default:
+		throw gpu_exception("Mapping is supported only for OpenCL buffers");
+	}
+
+	return 0;
+}
+
+void shared_device_buffer::unmap(void *ptr)
+{
+	Context context;
+	switch (context.type()) {
+	case Context::TypeOpenCL:
+		context.cl()->unmapBuffer((cl_mem) data_, ptr);
+		break;
+	default:
+		throw gpu_exception("Mapping is supported only for OpenCL buffers");
+	}
+}
+
+ocl::OpenCLEvent shared_device_buffer::writeAsync(const void *data, size_t size, const ocl::OpenCLStream &stream)
+{
+	if (size == 0)
+		return ocl::OpenCLEvent();
+
+	if (size > size_)
+		throw gpu_exception("Too many data for this device buffer: " + to_string(size) + " > " + to_string(size_));
+
+	Context context;
+	switch (context.type()) {
+#ifdef CUDA_SUPPORT
+	case Context::TypeCUDA:
+		CUDA_SAFE_CALL(cudaMemcpy(cuptr(), data, size, cudaMemcpyHostToDevice));
+		return ocl::OpenCLEvent();
+#endif
+	case Context::TypeOpenCL:
+		return context.cl()->writeBufferAsync((cl_mem) data_, offset_, size, data, stream);
+	default:
+		gpu::raiseException(__FILE__, __LINE__, "No GPU context!");
+	}
+
+	return ocl::OpenCLEvent();
+}
+
+ocl::OpenCLEvent shared_device_buffer::readAsync(void *data, size_t size, size_t offset, const ocl::OpenCLStream &stream) const
+{
+	if (size == 0)
+		return ocl::OpenCLEvent();
+	if (size > size_)
+		throw gpu_exception("Not enough data in this device buffer: " + to_string(size) + " > " + to_string(size_));
+
+	Context context;
+	switch (context.type()) {
+#ifdef CUDA_SUPPORT
+	case Context::TypeCUDA:
+		CUDA_SAFE_CALL(cudaMemcpy(data, (char *) cuptr() + offset, size, cudaMemcpyDeviceToHost));
+		return ocl::OpenCLEvent();
+#endif
+	case Context::TypeOpenCL:
+		return context.cl()->readBufferAsync((cl_mem) data_, offset_ + offset, size, data, stream);
+	default:
+		gpu::raiseException(__FILE__, __LINE__, "No GPU context!");
+	}
+
+	return ocl::OpenCLEvent();
+}
+
 template <typename T>
 shared_device_buffer_typed<T> shared_device_buffer_typed<T>::createN(size_t number)
 {
@@ -393,6 +585,12 @@ void shared_device_buffer_typed<T>::growN(size_t number, float reserveMultiplier
 	this->grow(number * sizeof(T), reserveMultiplier);
 }
 
+template <typename T>
+void shared_device_buffer_typed<T>::resizeHostSharedN(size_t number)
+{
+	this->resizeHostShared(number * sizeof(T));
+}
+
 template <typename T>
 T *shared_device_buffer_typed<T>::cuptr() const
 {
@@ -410,12 +608,31 @@ void shared_device_buffer_typed<T>::readN(T* data, size_t number, size_t offset)
 	this->read(data, number * sizeof(T), offset * sizeof(T));
 }
 
+template<typename T>
+ocl::OpenCLEvent shared_device_buffer_typed<T>::writeNAsync(const T* data, size_t number, const ocl::OpenCLStream &stream)
+{
+	return this->writeAsync(data, number * sizeof(T), stream);
+}
+
+template<typename T>
+ocl::OpenCLEvent shared_device_buffer_typed<T>::readNAsync(T* data, size_t number, size_t offset, const ocl::OpenCLStream &stream) const
+{
+	return this->readAsync(data, number * sizeof(T), offset * sizeof(T), stream);
+}
+
 template<typename T>
 void shared_device_buffer_typed<T>::copyToN(shared_device_buffer_typed<T> &that, size_t number) const
 {
 	this->copyTo(that, number * sizeof(T));
 }
 
+template<typename T>
+mapped_span<T> shared_device_buffer_typed<T>::mapN(unsigned int mode, size_t number, size_t offset)
+{
+	T *data = (T *) this->map(mode, number * sizeof(T), offset * sizeof(T));
+	return mapped_span<T>(*this, data, number);
+}
+
 template class shared_device_buffer_typed<int8_t>;
 template class shared_device_buffer_typed<int16_t>;
 template class shared_device_buffer_typed<int32_t>;
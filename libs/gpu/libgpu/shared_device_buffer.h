@@ -1,12 +1,25 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 #include "shared_host_buffer.h"
+#include <libgpu/utils.h>
+#include <libgpu/opencl/event.h>
 
 typedef struct _cl_mem *cl_mem;
 
+namespace ocl {
+	class BufferPool;
+}
+
 namespace gpu {
 
+enum MapMode {
+	MapRead		= 1,
+	MapWrite	= 2,
+	MapDiscard	= 4,	// with MapWrite: previous contents are not transferred to the host (since OpenCL 1.2, ignored before)
+};
+
 class shared_device_buffer {
 public:
 	shared_device_buffer();
@@ -19,22 +32,41 @@ public:
 	size_t			size() const;
 	void			resize(size_t size);
 	void			grow(size_t size, float reserveMultiplier=1.1f);
+	// Allocates the buffer over page-aligned host memory (CL_MEM_USE_HOST_PTR): on devices with host unified memory
+	// (see ocl::DeviceInfo::host_unified_memory) kernels and map() work with it in place, without copies.
+	// Falls back to resize() on OpenCL 1.0 platforms
+	void			resizeHostShared(size_t size);
+	bool			isHostShared() const;
 	bool 			isNull() const;
 
 	void *			cuptr() const;
 	cl_mem			clmem() const;
 	size_t			cloffset() const;
+	// Memory object starting at cloffset(): the buffer itself or its cached sub-buffer (the offset must be aligned to CL_DEVICE_MEM_BASE_ADDR_ALIGN)
+	cl_mem			clmemView() const;
 
 	void 			write(const void *data, size_t size);
 	void			write(const shared_device_buffer &buffer, size_t size);
+	// Pinned host buffers (see shared_host_buffer::isPinned()) are transferred by DMA directly, paged ones through a driver staging copy
 	void			write(const shared_host_buffer &buffer, size_t size);
 	void			write2D(size_t dpitch, const void *src, size_t spitch, size_t width, size_t height);
 
 	void			read(void *data, size_t size, size_t offset = 0) const;
+	void			read(shared_host_buffer &buffer, size_t size, size_t offset = 0) const;
 	void 			read2D(size_t spitch, void *dst, size_t dpitch, size_t width, size_t height) const;
 
 	void 			copyTo(shared_device_buffer &that, size_t size) const;
 
+	// Blocking map of [offset, offset + size) for the host with MapMode flags. Kernels must not use the buffer until unmap(),
+	// on host unified memory devices no data is copied
+	void *			map(unsigned int mode, size_t size, size_t offset = 0);
+	void			unmap(void *ptr);
+
+	// Non-blocking transfers, host memory must stay valid until the returned event is finished
+	// (on CUDA the transfer is synchronous and the returned event is empty)
+	ocl::OpenCLEvent	writeAsync(const void *data, size_t size, const ocl::OpenCLStream &stream = ocl::OpenCLStream());
+	ocl::OpenCLEvent	readAsync(void *data, size_t size, size_t offset = 0, const ocl::OpenCLStream &stream = ocl::OpenCLStream()) const;
+
 	static shared_device_buffer create(size_t size);
 
 protected:
@@ -46,6 +78,49 @@ protected:
 	int				type_;
 	size_t			size_;
 	size_t			offset_;
+	std::shared_ptr<ocl::BufferPool>	pool_;	// OpenCL memory is returned to the pool of its engine
+};
+
+// Mapped region of a device buffer, unmapped on destruction. Keeps the buffer alive
+template <typename T>
+class mapped_span {
+public:
+	mapped_span(const shared_device_buffer &buffer, T *data, size_t number) : buffer_(buffer), data_(data), number_(number) {}
+	mapped_span(mapped_span &&other) : buffer_(other.buffer_), data_(other.data_), number_(other.number_)	{ other.data_ = 0;	}
+	~mapped_span()
+	{
+		try {
+			unmap();
+		} catch (gpu_exception &) {
+			// use unmap() to get the error
+		}
+	}
+
+	T *				data() const				{ return data_;				}
+	size_t			size() const				{ return number_;			}
+	T *				begin() const				{ return data_;				}
+	T *				end() const					{ return data_ + number_;	}
+	T &				operator[](size_t i) const	{ return data_[i];			}
+
+	// The span is empty after it
+	void			unmap()
+	{
+		if (!data_)
+			return;
+
+		T *data = data_;
+		data_	= 0;
+		number_	= 0;
+		buffer_.unmap(data);
+	}
+
+protected:
+	mapped_span(const mapped_span &);
+	mapped_span &operator= (const mapped_span &);
+
+	shared_device_buffer	buffer_;
+	T *						data_;
+	size_t					number_;
 };
 
 template <typename T>
@@ -59,6 +134,7 @@ public:
 
 	void			resizeN(size_t number);
 	void			growN(size_t number, float reserveMultiplier=1.1f);
+	void			resizeHostSharedN(size_t number);
 
 	T *				cuptr() const;
 
@@ -66,8 +142,13 @@ public:
 
 	void			readN(T* data, size_t number, size_t offset = 0) const;
 
+	ocl::OpenCLEvent	writeNAsync(const T* data, size_t number, const ocl::OpenCLStream &stream = ocl::OpenCLStream());
+	ocl::OpenCLEvent	readNAsync(T* data, size_t number, size_t offset = 0, const ocl::OpenCLStream &stream = ocl::OpenCLStream()) const;
+
 	void			copyToN(shared_device_buffer_typed<T> &that, size_t number) const;
 
+	mapped_span<T>	mapN(unsigned int mode, size_t number, size_t offset = 0);
+
 	static shared_device_buffer_typed<T> createN(size_t number);
 };
 
@@ -1,5 +1,6 @@
 #include "shared_host_buffer.h"
 #include "context.h"
+#include <libgpu/opencl/engine.h>
 #include <algorithm>
 #include <stdexcept>
 
@@ -19,6 +20,7 @@ shared_host_buffer::shared_host_buffer()
 	data_	= 0;
 	type_	= Context::TypeUndefined;
 	size_	= 0;
+	clmem_	= 0;
 }
 
 shared_host_buffer::~shared_host_buffer()
@@ -32,6 +34,8 @@ shared_host_buffer::shared_host_buffer(const shared_host_buffer &other)
 	data_	= other.data_;
 	type_	= other.type_;
 	size_	= other.size_;
+	clmem_	= other.clmem_;
+	engine_	= other.engine_;
 	incref();
 }
 
@@ -43,6 +47,8 @@ shared_host_buffer &shared_host_buffer::operator= (const shared_host_buffer &oth
 		data_	= other.data_;
 		type_	= other.type_;
 		size_	= other.size_;
+		clmem_	= other.clmem_;
+		engine_	= other.engine_;
 		incref();
 	}
 
@@ -55,6 +61,8 @@ void shared_host_buffer::swap(shared_host_buffer &other)
 	std::swap(data_,	other.data_);
 	std::swap(type_,	other.type_);
 	std::swap(size_,	other.size_);
+	std::swap(clmem_,	other.clmem_);
+	std::swap(engine_,	other.engine_);
 }
 
 void shared_host_buffer::incref()
@@ -96,7 +104,16 @@ void shared_host_buffer::decref()
 		break;
 #endif
 	case Context::TypeOpenCL:
-		free(data_);
+		if (clmem_) {
+			try {
+				engine_->unmapBuffer(clmem_, data_);
+			} catch (gpu_exception &) {
+				// the buffer is released anyway
+			}
+			clReleaseMemObject(clmem_);
+		} else {
+			free(data_);
+		}
 		break;
 	default:
 		gpu::raiseException(__FILE__, __LINE__, "No GPU context!");
@@ -108,6 +125,8 @@ void shared_host_buffer::decref()
 	data_	= 0;
 	type_	= Context::TypeUndefined;
 	size_	= 0;
+	clmem_	= 0;
+	engine_.reset();
 }
 
 shared_host_buffer shared_host_buffer::create(size_t size)
@@ -117,6 +136,13 @@ shared_host_buffer shared_host_buffer::create(size_t size)
 	return res;
 }
 
+shared_host_buffer shared_host_buffer::createPaged(size_t size)
+{
+	shared_host_buffer res;
+	res.allocate(size, false);
+	return res;
+}
+
 void *shared_host_buffer::get() const
 {
 	return data_;
@@ -127,11 +153,21 @@ size_t shared_host_buffer::size() const
 	return size_;
 }
 
+bool shared_host_buffer::isPinned() const
+{
+	return type_ == Context::TypeCUDA || clmem_ != 0;
+}
+
 void shared_host_buffer::resize(size_t size)
 {
 	if (size == size_)
 		return;
 
+	allocate(size, true);
+}
+
+void shared_host_buffer::allocate(size_t size, bool pinned)
+{
 	decref();
 
 	buffer_	= new unsigned char [8];
@@ -148,8 +184,24 @@ void shared_host_buffer::resize(size_t size)
 		break;
 #endif
 	case Context::TypeOpenCL:
-		// NOTTODO: implement pinned memory in opencl
-		// currently we use a plain paged memory buffer
+		if (pinned && size) {
+			engine_ = context.cl();
+
+			cl_int status = CL_SUCCESS;
+			clmem_ = clCreateBuffer(engine_->context(), CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size, NULL, &status);
+			try {
+				OCL_SAFE_CALL(status);
+				data_ = engine_->mapBuffer(clmem_, CL_MAP_READ | CL_MAP_WRITE, 0, size);
+				break;
+			} catch (gpu_exception &) {
+				// pinned memory is limited, paged memory is used then
+				if (clmem_)
+					clReleaseMemObject(clmem_);
+				clmem_	= 0;
+				engine_.reset();
+			}
+		}
+
 		data_ = malloc(size);
 		if (!data_)
 			throw std::bad_alloc();
@@ -1,8 +1,15 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 #include <stdint.h>
 
+typedef struct _cl_mem *cl_mem;
+
+namespace ocl {
+	class OpenCLEngine;
+}
+
 namespace gpu {
 
 class shared_host_buffer {
@@ -18,16 +25,27 @@ public:
 	void			resize(size_t size);
 	void			grow(size_t size);
 
+	// OpenCL host memory is a persistently mapped CL_MEM_ALLOC_HOST_PTR buffer (page-locked on most drivers),
+	// so transfers from and to it are done by DMA without a staging copy. Falls back to malloc if it can't be allocated
+	bool			isPinned() const;
+	// Engine that owns the pinned buffer, null for malloc memory
+	const std::shared_ptr<ocl::OpenCLEngine> &	engine() const	{ return engine_;	}
+
 	static shared_host_buffer create(size_t size);
+	// Plain paged memory on OpenCL (CUDA host memory is always pinned), for comparison with pinned memory
+	static shared_host_buffer createPaged(size_t size);
 
 protected:
 	void	incref();
 	void	decref();
+	void	allocate(size_t size, bool pinned);
 
 	unsigned char *	buffer_;
 	void *			data_;
 	int				type_;
 	size_t			size_;
+	cl_mem			clmem_;		// mapped to data_ if the memory is pinned
+	std::shared_ptr<ocl::OpenCLEngine>	engine_;
 };
 
 template <typename T>
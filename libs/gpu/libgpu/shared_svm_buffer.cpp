@@ -0,0 +1,228 @@
+#include "shared_svm_buffer.h"
+#include "context.h"
+#include <libgpu/opencl/engine.h>
+#include <libclew/ocl_svm.h>
+#include <algorithm>
+#include <cstring>
+
+namespace gpu {
+
+struct shared_svm_buffer::Allocation {
+	Allocation(const ocl::sh_ptr_ocl_engine &engine, void *ptr, bool fine_grained) : engine(engine), ptr(ptr), fine_grained(fine_grained) {}
+
+	~Allocation()
+	{
+		try {
+			engine->svmFree(ptr);
+		} catch (gpu_exception &) {
+			// the memory is lost
+		}
+	}
+
+	ocl::sh_ptr_ocl_engine	engine;
+	void *					ptr;
+	bool					fine_grained;
+};
+
+shared_svm_buffer::shared_svm_buffer()
+{
+	size_	= 0;
+}
+
+shared_svm_buffer::~shared_svm_buffer()
+{
+}
+
+shared_svm_buffer::shared_svm_buffer(const shared_svm_buffer &other)
+{
+	svm_	= other.svm_;
+	buffer_	= other.buffer_;
+	size_	= other.size_;
+}
+
+shared_svm_buffer &shared_svm_buffer::operator= (const shared_svm_buffer &other)
+{
+	if (this != &other) {
+		svm_	= other.svm_;
+		buffer_	= other.buffer_;
+		size_	= other.size_;
+	}
+
+	return *this;
+}
+
+void shared_svm_buffer::swap(shared_svm_buffer &other)
+{
+	std::swap(svm_,		other.svm_);
+	buffer_.swap(other.buffer_);
+	std::swap(size_,	other.size_);
+}
+
+void shared_svm_buffer::reset()
+{
+	svm_.reset();
+	buffer_.reset();
+	size_	= 0;
+}
+
+size_t shared_svm_buffer::size() const
+{
+	return size_;
+}
+
+bool shared_svm_buffer::isNull() const
+{
+	return !svm_ && buffer_.isNull();
+}
+
+bool shared_svm_buffer::isSVM() const
+{
+	return svm_ != 0;
+}
+
+bool shared_svm_buffer::isFineGrained() const
+{
+	return svm_ && svm_->fine_grained;
+}
+
+void *shared_svm_buffer::svmptr() const
+{
+	return svm_ ? svm_->ptr : 0;
+}
+
+shared_svm_buffer shared_svm_buffer::create(size_t size)
+{
+	shared_svm_buffer res;
+	res.resize(size);
+	return res;
+}
+
+void shared_svm_buffer::resize(size_t size)
+{
+	if (size == size_)
+		return;
+
+	reset();
+
+	Context context;
+	if (context.type() == Context::TypeOpenCL) {
+		const ocl::sh_ptr_ocl_engine &engine = context.cl();
+		bool fine_grained = engine->deviceInfo().hasFineGrainedSVM();
+
+		void *ptr = engine->svmAlloc(fine_grained ? CL_MEM_SVM_FINE_GRAIN_BUFFER : 0, size);
+		if (ptr) {
+			svm_	= std::make_shared<Allocation>(engine, ptr, fine_grained);
+			size_	= size;
+			return;
+		}
+	}
+
+	buffer_.resize(size);
+	size_	= size;
+}
+
+void *shared_svm_buffer::map(unsigned int mode) const
+{
+	if (!svm_)
+		return const_cast<shared_device_buffer &>(buffer_).map(mode, size_);
+
+	if (svm_->fine_grained)
+		return svm_->ptr;
+
+	cl_map_flags flags = 0;
+	if (mode & MapRead)
+		flags |= CL_MAP_READ;
+	if (mode & MapWrite)
+		flags |= (mode & MapDiscard) && !(mode & MapRead) ? CL_MAP_WRITE_INVALIDATE_REGION : CL_MAP_WRITE;
+
+	svm_->engine->svmMap(svm_->ptr, flags, size_);
+	return svm_->ptr;
+}
+
+void shared_svm_buffer::unmap(void *ptr) const
+{
+	if (!svm_) {
+		const_cast<shared_device_buffer &>(buffer_).unmap(ptr);
+	} else if (!svm_->fine_grained) {
+		svm_->engine->svmUnmap(ptr);
+	}
+}
+
+void shared_svm_buffer::write(const void *data, size_t size)
+{
+	if (size > size_)
+		throw gpu_exception("Too many data for this SVM buffer: " + to_string(size) + " > " + to_string(size_));
+
+	if (!svm_) {
+		buffer_.write(data, size);
+		return;
+	}
+
+	void *ptr = map(size == size_ ? MapWrite | MapDiscard : MapWrite);
+	memcpy(ptr, data, size);
+	unmap(ptr);
+}
+
+void shared_svm_buffer::read(void *data, size_t size) const
+{
+	if (size > size_)
+		throw gpu_exception("Not enough data in this SVM buffer: " + to_string(size) + " > " + to_string(size_));
+
+	if (!svm_) {
+		buffer_.read(data, size);
+		return;
+	}
+
+	void *ptr = map(MapRead);
+	memcpy(data, ptr, size);
+	unmap(ptr);
+}
+
+template <typename T>
+shared_svm_buffer_typed<T> shared_svm_buffer_typed<T>::createN(size_t number)
+{
+	shared_svm_buffer_typed<T> res;
+	res.resizeN(number);
+	return res;
+}
+
+template <typename T>
+size_t shared_svm_buffer_typed<T>::number() const
+{
+	return this->size_ / sizeof(T);
+}
+
+template <typename T>
+void shared_svm_buffer_typed<T>::resizeN(size_t number)
+{
+	this->resize(number * sizeof(T));
+}
+
+template <typename T>
+T *shared_svm_buffer_typed<T>::svmptr() const
+{
+	return (T *) shared_svm_buffer::svmptr();
+}
+
+template <typename T>
+void shared_svm_buffer_typed<T>::writeN(const T* data, size_t number)
+{
+	this->write(data, number * sizeof(T));
+}
+
+template <typename T>
+void shared_svm_buffer_typed<T>::readN(T* data, size_t number) const
+{
+	this->read(data, number * sizeof(T));
+}
+
+template class shared_svm_buffer_typed<char>;
+template class shared_svm_buffer_typed<unsigned char>;
+template class shared_svm_buffer_typed<short>;
+template class shared_svm_buffer_typed<unsigned short>;
+template class shared_svm_buffer_typed<int>;
+template class shared_svm_buffer_typed<unsigned int>;
+template class shared_svm_buffer_typed<float>;
+template class shared_svm_buffer_typed<double>;
+
+}
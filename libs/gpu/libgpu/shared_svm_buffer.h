@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "shared_device_buffer.h"
+
+namespace gpu {
+
+// Buffer in OpenCL 2.0 shared virtual memory: svmptr() is the same address on the host and in kernels, so pointer-based
+// structures (trees, linked graphs) built in it are shared without serialization. Fine-grained SVM is used if the device
+// supports it (the host works with svmptr() directly), coarse-grained otherwise (the host works with it between map() and unmap()).
+// Without SVM support falls back to a regular shared_device_buffer transparently, but pointers stored in it are not valid in kernels then.
+// Dropping the last reference waits for all queues of the engine, so the memory is not freed under running commands.
+class shared_svm_buffer {
+public:
+	shared_svm_buffer();
+	~shared_svm_buffer();
+	shared_svm_buffer(const shared_svm_buffer &other);
+	shared_svm_buffer &operator= (const shared_svm_buffer &other);
+
+	void			swap(shared_svm_buffer &other);
+	void			reset();
+	size_t			size() const;
+	void			resize(size_t size);
+	bool			isNull() const;
+
+	bool			isSVM() const;
+	bool			isFineGrained() const;
+	// 0 for the fallback buffer
+	void *			svmptr() const;
+	// Null unless the buffer is a fallback
+	const shared_device_buffer &	buffer() const	{ return buffer_;	}
+
+	// Host access to the whole buffer with MapMode flags, kernels must not use it until unmap() (no-op for fine-grained SVM)
+	void *			map(unsigned int mode) const;
+	void			unmap(void *ptr) const;
+
+	void			write(const void *data, size_t size);
+	void			read(void *data, size_t size) const;
+
+	static shared_svm_buffer create(size_t size);
+
+protected:
+	struct Allocation;
+
+	std::shared_ptr<Allocation>	svm_;
+	shared_device_buffer		buffer_;
+	size_t						size_;
+};
+
+template <typename T>
+class shared_svm_buffer_typed : public shared_svm_buffer {
+public:
+	size_t			number() const;
+
+	void			resizeN(size_t number);
+
+	T *				svmptr() const;
+
+	void			writeN(const T* data, size_t number);
+	void			readN(T* data, size_t number) const;
+
+	static shared_svm_buffer_typed<T> createN(size_t number);
+};
+
+typedef shared_svm_buffer							gpu_svm_any;
+
+typedef shared_svm_buffer_typed<int32_t>			gpu_svm_32i;
+typedef shared_svm_buffer_typed<uint32_t>			gpu_svm_32u;
+typedef shared_svm_buffer_typed<float>				gpu_svm_32f;
+
+}
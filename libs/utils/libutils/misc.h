@@ -1,5 +1,6 @@
 #pragma once
 
+#include <libgpu/batch.h>
 #include <libgpu/device.h>
 #include <libgpu/opencl/engine.h>
 #include <libgpu/opencl/device_info.h>
@@ -8,6 +9,7 @@
 
 #include <string>
 #include <limits>
+#include <type_traits>
 #include <iostream>
 #include <stdexcept>
 
@@ -45,15 +47,147 @@ namespace ocl {
 
 		typedef ocl::OpenCLKernel::Arg Arg;
 
-		void exec(const gpu::WorkSize &ws, const Arg &arg0 = Arg(), const Arg &arg1 = Arg(), const Arg &arg2 = Arg(), const Arg &arg3 = Arg(), const Arg &arg4 = Arg(), const Arg &arg5 = Arg(), const Arg &arg6 = Arg(), const Arg &arg7 = Arg(), const Arg &arg8 = Arg(), const Arg &arg9 = Arg(), const Arg &arg10 = Arg(), const Arg &arg11 = Arg(), const Arg &arg12 = Arg(), const Arg &arg13 = Arg(), const Arg &arg14 = Arg(), const Arg &arg15 = Arg(), const Arg &arg16 = Arg(), const Arg &arg17 = Arg(), const Arg &arg18 = Arg(), const Arg &arg19 = Arg(), const Arg &arg20 = Arg(), const Arg &arg21 = Arg(), const Arg &arg22 = Arg(), const Arg &arg23 = Arg(), const Arg &arg24 = Arg(), const Arg &arg25 = Arg(), const Arg &arg26 = Arg(), const Arg &arg27 = Arg(), const Arg &arg28 = Arg(), const Arg &arg29 = Arg(), const Arg &arg30 = Arg(), const Arg &arg31 = Arg(), const Arg &arg32 = Arg(), const Arg &arg33 = Arg(), const Arg &arg34 = Arg(), const Arg &arg35 = Arg(), const Arg &arg36 = Arg(), const Arg &arg37 = Arg(), const Arg &arg38 = Arg(), const Arg &arg39 = Arg(), const Arg &arg40 = Arg())
+		template <typename... Args>
+		void exec(const gpu::WorkSize &ws, const Args &... args)
 		{
 			if (!kernel_)
 				throw std::runtime_error("Null kernel!");
-			kernel_->exec(ws, arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13, arg14, arg15, arg16, arg17, arg18, arg19, arg20, arg21, arg22, arg23, arg24, arg25, arg26, arg27, arg28, arg29, arg30, arg31, arg32, arg33, arg34, arg35, arg36, arg37, arg38, arg39, arg40);
+			kernel_->exec(ws, args...);
+		}
+
+		template <typename... Args>
+		ocl::OpenCLEvent execAsync(const gpu::WorkSize &ws, const Args &... args)
+		{
+			if (!kernel_)
+				throw std::runtime_error("Null kernel!");
+			return kernel_->execAsync(ws, args...);
+		}
+
+		template <typename... Args>
+		ocl::OpenCLEvent execAsync(const ocl::OpenCLStream &stream, const gpu::WorkSize &ws, const Args &... args)
+		{
+			if (!kernel_)
+				throw std::runtime_error("Null kernel!");
+			return kernel_->execAsync(stream, ws, args...);
+		}
+
+		// Local size is auto-tuned per device and persisted, see KernelSource::execTunedArray()
+		template <typename... Args>
+		void execTuned(const gpu::WorkSize &ws, const Args &... args)
+		{
+			if (!kernel_)
+				throw std::runtime_error("Null kernel!");
+			kernel_->execTuned(ws, args...);
+		}
+
+		// Records the launch into the batch instead of executing it, see gpu::Batch
+		template <typename... Args>
+		void record(gpu::Batch &batch, const gpu::WorkSize &ws, const Args &... args)
+		{
+			if (!kernel_)
+				throw std::runtime_error("Null kernel!");
+			batch.exec(*kernel_, ws, args...);
 		}
 
 	private:
 		std::shared_ptr<ocl::ProgramBinaries> program_;
 		std::shared_ptr<ocl::KernelSource> kernel_;
 	};
+
+	template <typename Param, typename Arg>
+	struct KernelArgMatches {
+		// integers of the same size are passed bitwise identically, e.g. int literal for an unsigned parameter
+		static const bool value = std::is_same<Param, Arg>::value
+				|| (std::is_integral<Param>::value && std::is_integral<Arg>::value && sizeof(Param) == sizeof(Arg));
+	};
+
+	template <typename T, typename Arg>
+	struct KernelArgMatches<T *, Arg> {
+		static const bool value = std::is_same<Arg, gpu::shared_device_buffer_typed<typename std::remove_const<T>::type> >::value
+				|| std::is_same<Arg, gpu::shared_device_buffer>::value
+				|| std::is_same<Arg, gpu::shared_svm_buffer_typed<typename std::remove_const<T>::type> >::value
+				|| std::is_same<Arg, gpu::shared_svm_buffer>::value;
+	};
+
+	template <typename... Params>
+	struct KernelParams { };
+
+	// Walks parameters and arguments together, an ocl::OffsetView argument takes a pointer and an unsigned int offset parameter
+	template <typename Params, typename... Args>
+	struct KernelArgsMatch {
+		static const bool value = false;
+	};
+
+	template <>
+	struct KernelArgsMatch<KernelParams<> > {
+		static const bool value = true;
+	};
+
+	template <typename Param, typename... Params, typename Arg, typename... Args>
+	struct KernelArgsMatch<KernelParams<Param, Params...>, Arg, Args...> {
+		static const bool value = KernelArgMatches<Param, Arg>::value && KernelArgsMatch<KernelParams<Params...>, Args...>::value;
+	};
+
+	template <typename T, typename Offset, typename... Params, typename... Args>
+	struct KernelArgsMatch<KernelParams<T *, Offset, Params...>, ocl::OffsetView, Args...> {
+		static const bool value = KernelArgMatches<Offset, unsigned int>::value && KernelArgsMatch<KernelParams<Params...>, Args...>::value;
+	};
+
+	// Kernel with a compile-time signature, e.g. TypedKernel<float*, const float*, unsigned int> for
+	// __kernel void f(__global float *a, __global const float *b, unsigned int n).
+	// Pointer parameters accept gpu::gpu_mem_any or gpu::shared_device_buffer_typed<T> with the same T (or their SVM counterparts), scalars accept only the same type
+	// (or an integer of the same size), LocalMem parameters accept ocl::LocalMem. ocl::OffsetView fills a pointer and the following unsigned int offset.
+	template <typename... Params>
+	class TypedKernel : public Kernel {
+	public:
+		TypedKernel() {}
+
+		TypedKernel(const char *source_code, size_t source_code_length, std::string kernel_name,
+					std::string defines = std::string()) : Kernel(source_code, source_code_length, kernel_name, defines)
+		{
+		}
+
+		template <typename... Args>
+		void exec(const gpu::WorkSize &ws, const Args &... args)
+		{
+			check<Args...>();
+			Kernel::exec(ws, args...);
+		}
+
+		template <typename... Args>
+		ocl::OpenCLEvent execAsync(const gpu::WorkSize &ws, const Args &... args)
+		{
+			check<Args...>();
+			return Kernel::execAsync(ws, args...);
+		}
+
+		template <typename... Args>
+		ocl::OpenCLEvent execAsync(const ocl::OpenCLStream &stream, const gpu::WorkSize &ws, const Args &... args)
+		{
+			check<Args...>();
+			return Kernel::execAsync(stream, ws, args...);
+		}
+
+		template <typename... Args>
+		void execTuned(const gpu::WorkSize &ws, const Args &... args)
+		{
+			check<Args...>();
+			Kernel::execTuned(ws, args...);
+		}
+
+		template <typename... Args>
+		void record(gpu::Batch &batch, const gpu::WorkSize &ws, const Args &... args)
+		{
+			check<Args...>();
+			Kernel::record(batch, ws, args...);
+		}
+
+	private:
+		template <typename... Args>
+		static void check()
+		{
+			static_assert(OpenCLKernelArgsCount<Args...>::value == sizeof...(Params), "Wrong number of kernel arguments!");
+			static_assert(KernelArgsMatch<KernelParams<Params...>, Args...>::value, "Kernel argument type does not match kernel signature!");
+		}
+	};
 }
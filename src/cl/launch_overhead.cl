@@ -0,0 +1,17 @@
+#ifdef __CLION_IDE__
+#include <libgpu/opencl/cl/clion_defines.cl>
+#endif
+
+#line 6
+
+// Почти пустой кернел: время его запуска определяется накладными расходами на постановку в очередь
+__kernel void increment(__global unsigned int* as,
+                        unsigned int n)
+{
+    const unsigned int index = get_global_id(0);
+
+    if (index >= n)
+        return;
+
+    as[index] += 1;
+}
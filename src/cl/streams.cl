@@ -0,0 +1,23 @@
+#ifdef __CLION_IDE__
+#include <libgpu/opencl/cl/clion_defines.cl>
+#endif
+
+#line 6
+
+// Несколько шагов линейного конгруэнтного генератора на элемент, чтобы вычисления занимали время, сравнимое с копированием
+__kernel void lcg(__global const unsigned int* as,
+                  __global       unsigned int* bs,
+                  unsigned int n,
+                  unsigned int steps)
+{
+    const unsigned int index = get_global_id(0);
+
+    if (index >= n)
+        return;
+
+    unsigned int x = as[index];
+    for (unsigned int i = 0; i < steps; ++i) {
+        x = x * 1664525u + 1013904223u;
+    }
+    bs[index] = x;
+}
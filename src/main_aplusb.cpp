@@ -43,27 +43,34 @@ int main(int argc, char **argv)
     context.activate();
 
     unsigned int n = 100*1000*1000;
-    std::vector<float> as(n, 0);
-    std::vector<float> bs(n, 0);
-    std::vector<float> cs(n, 0);
-    FastRandom r(n);
-    for (unsigned int i = 0; i < n; ++i) {
-        as[i] = r.nextf();
-        bs[i] = r.nextf();
-    }
-    std::cout << "Data generated for n=" << n << "!" << std::endl;
 
     // Создаем три буфера в видеопамяти
+    // На CPU и интегрированных видеокартах видеопамять - это оперативная память, поэтому буферы создаются поверх памяти хоста
+    // и дальше хост и кернел работают с одной и той же копией данных
     gpu::gpu_mem_32f as_gpu, bs_gpu, cs_gpu;
-    as_gpu.resizeN(n);
-    bs_gpu.resizeN(n);
-    cs_gpu.resizeN(n);
+    if (context.cl()->deviceInfo().host_unified_memory) {
+        as_gpu.resizeHostSharedN(n);
+        bs_gpu.resizeHostSharedN(n);
+        cs_gpu.resizeHostSharedN(n);
+    } else {
+        as_gpu.resizeN(n);
+        bs_gpu.resizeN(n);
+        cs_gpu.resizeN(n);
+    }
 
-    // Прогружаем данные из векторов as и bs
-    // (есть нетипизированный метод write для которого количество измеряется в байтах,
-    // и типизированный writeN, для которого количество измеряется в количестве float-элементов, т.к. gpu::gpu_mem_32f - это shared_device_buffer_typed<float>)
-    as_gpu.writeN(as.data(), n);
-    bs_gpu.writeN(bs.data(), n);
+    // Генерируем данные прямо в отображенной (mapped) памяти буферов
+    // (MapDiscard - старое содержимое не нужно, его не надо копировать на хост;
+    // на дискретной видеокарте данные будут скопированы при unmap, т.е. при выходе из блока, а на CPU копирований не будет вовсе)
+    {
+        gpu::mapped_span<float> as = as_gpu.mapN(gpu::MapWrite | gpu::MapDiscard, n);
+        gpu::mapped_span<float> bs = bs_gpu.mapN(gpu::MapWrite | gpu::MapDiscard, n);
+        FastRandom r(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            as[i] = r.nextf();
+            bs[i] = r.nextf();
+        }
+    }
+    std::cout << "Data generated for n=" << n << "!" << std::endl;
 
     // Исходники кернела написаны в src/cl/aplusb.cl
     // Но благодаря convertIntoHeader(src/cl/aplusb.cl src/cl/aplusb_cl.h aplusb_kernel) (см. CMakeLists.txt:18)
@@ -74,10 +81,15 @@ int main(int argc, char **argv)
 
     unsigned int workGroupSize = 128;
     unsigned int global_work_size = (n + workGroupSize - 1) / workGroupSize * workGroupSize;
-    aplusb.exec(gpu::WorkSize(workGroupSize, global_work_size),
-                as_gpu, bs_gpu, cs_gpu, n);
-
-    cs_gpu.readN(cs.data(), n);
+    // Размер рабочей группы подбирается при первом запуске на устройстве и запоминается в кэше на диске,
+    // workGroupSize - лишь один из кандидатов
+    aplusb.execTuned(gpu::WorkSize(workGroupSize, global_work_size),
+                     as_gpu, bs_gpu, cs_gpu, n);
+
+    // Вместо чтения результатов через readN отображаем буферы на память хоста
+    gpu::mapped_span<float> as = as_gpu.mapN(gpu::MapRead, n);
+    gpu::mapped_span<float> bs = bs_gpu.mapN(gpu::MapRead, n);
+    gpu::mapped_span<float> cs = cs_gpu.mapN(gpu::MapRead, n);
 
     // Проверяем корректность результатов
     for (int i = 0; i < n; ++i) {
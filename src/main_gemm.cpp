@@ -0,0 +1,131 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/primitives/gemm.h>
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+// Эталонное умножение на процессоре: C = alpha * op(A) * op(B) + beta * C
+template <typename T>
+void cpuGemm(const std::vector<T> &a, const std::vector<T> &b, std::vector<T> &c, unsigned int m, unsigned int n, unsigned int k,
+             T alpha, T beta, gpu::GemmOp op_a, gpu::GemmOp op_b)
+{
+    #pragma omp parallel for
+    for (int i = 0; i < (int) m; ++i) {
+        for (unsigned int j = 0; j < n; ++j) {
+            double sum = 0.0;
+            for (unsigned int l = 0; l < k; ++l) {
+                T x = op_a == gpu::GemmTransposed ? a[(size_t) l * m + i] : a[(size_t) i * k + l];
+                T y = op_b == gpu::GemmTransposed ? b[(size_t) j * k + l] : b[(size_t) l * n + j];
+                sum += (double) x * y;
+            }
+            c[(size_t) i * n + j] = (T) (alpha * sum + beta * c[(size_t) i * n + j]);
+        }
+    }
+}
+
+// Сравнивает результат с процессором на всех сочетаниях транспонирований, размеры специально не кратны тайлам
+template <typename T>
+void check(unsigned int m, unsigned int n, unsigned int k, T eps)
+{
+    std::vector<T> a((size_t) m * k), b((size_t) k * n), c0((size_t) m * n);
+    FastRandom r(m + n + k);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = (T) r.nextf();
+    for (size_t i = 0; i < b.size(); ++i) b[i] = (T) r.nextf();
+    for (size_t i = 0; i < c0.size(); ++i) c0[i] = (T) r.nextf();
+
+    gpu::shared_device_buffer_typed<T> a_gpu, b_gpu, c_gpu;
+    a_gpu.resizeN(a.size());
+    b_gpu.resizeN(b.size());
+    c_gpu.resizeN(c0.size());
+    a_gpu.writeN(a.data(), a.size());
+    b_gpu.writeN(b.data(), b.size());
+
+    for (int ops = 0; ops < 4; ++ops) {
+        gpu::GemmOp op_a = (ops & 1) ? gpu::GemmTransposed : gpu::GemmNormal;
+        gpu::GemmOp op_b = (ops & 2) ? gpu::GemmTransposed : gpu::GemmNormal;
+
+        std::vector<T> c = c0;
+        cpuGemm(a, b, c, m, n, k, (T) 0.5, (T) 2, op_a, op_b);
+
+        c_gpu.writeN(c0.data(), c0.size());
+        gpu::gemm(a_gpu, b_gpu, c_gpu, m, n, k, (T) 0.5, (T) 2, op_a, op_b);
+
+        std::vector<T> res(c0.size());
+        c_gpu.readN(res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i) {
+            EXPECT_THE_SAME(true, std::abs(res[i] - c[i]) <= eps * k, "GPU GEMM should be the same as CPU!");
+        }
+    }
+}
+
+template <typename T>
+void benchmark(const std::string &name, unsigned int n, int iters)
+{
+    std::vector<T> a((size_t) n * n), b((size_t) n * n);
+    FastRandom r(n);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = (T) r.nextf();
+    for (size_t i = 0; i < b.size(); ++i) b[i] = (T) r.nextf();
+
+    gpu::shared_device_buffer_typed<T> a_gpu, b_gpu, c_gpu;
+    a_gpu.resizeN(a.size());
+    b_gpu.resizeN(b.size());
+    c_gpu.resizeN(a.size());
+    a_gpu.writeN(a.data(), a.size());
+    b_gpu.writeN(b.data(), b.size());
+
+    // Первый запуск компилирует кернел, поэтому не замеряется
+    gpu::gemm(a_gpu, b_gpu, c_gpu, n, n, n);
+
+    timer t;
+    for (int iter = 0; iter < iters; ++iter) {
+        gpu::gemm(a_gpu, b_gpu, c_gpu, n, n, n);
+        t.nextLap();
+    }
+    std::cout << "GPU " << name << " " << n << "x" << n << ": " << t.lapAvg() << "+-" << t.lapStd() << " s, "
+              << 2.0 * n * n * n / t.lapAvg() / 1e9 << " GFlops" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 2048;
+    int iters = 10;
+
+    check<float>(257, 130, 77, 1e-5f);
+    check<float>(3, 1000, 5, 1e-5f);
+    benchmark<float>("SGEMM", n, iters);
+
+    // Двойная точность есть не на всех устройствах
+    if (context.cl()->deviceInfo().extensions.count("cl_khr_fp64") > 0) {
+        check<double>(257, 130, 77, 1e-12);
+        benchmark<double>("DGEMM", n, iters);
+    } else {
+        std::cout << "DGEMM is skipped: no cl_khr_fp64" << std::endl;
+    }
+
+    return 0;
+}
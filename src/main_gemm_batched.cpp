@@ -0,0 +1,102 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/primitives/gemm_batched.h>
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+// Пачка квадратных матриц size x size, всего около n чисел в каждом из массивов A, B и C.
+// При stride_a = 0 все B умножаются на одну и ту же A (например, одно преобразование для множества точек)
+void benchmark(unsigned int size, unsigned int n, bool same_a, int iters)
+{
+    unsigned int matrix = size * size;
+    unsigned int batch = n / matrix;
+    unsigned int stride_a = same_a ? 0 : matrix;
+
+    std::vector<float> a(same_a ? matrix : (size_t) batch * matrix), b((size_t) batch * matrix);
+    FastRandom r(size);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = r.nextf();
+    for (size_t i = 0; i < b.size(); ++i) b[i] = r.nextf();
+
+    gpu::gpu_mem_32f a_gpu, b_gpu, c_gpu;
+    a_gpu.resizeN(a.size());
+    b_gpu.resizeN(b.size());
+    c_gpu.resizeN(b.size());
+    a_gpu.writeN(a.data(), a.size());
+    b_gpu.writeN(b.data(), b.size());
+
+    // Первый запуск компилирует кернел для этого размера, поэтому не замеряется
+    gpu::gemmStridedBatched(a_gpu, stride_a, b_gpu, matrix, c_gpu, matrix, size, size, size, batch);
+
+    timer t;
+    for (int iter = 0; iter < iters; ++iter) {
+        gpu::gemmStridedBatched(a_gpu, stride_a, b_gpu, matrix, c_gpu, matrix, size, size, size, batch);
+        t.nextLap();
+    }
+    std::cout << "GPU " << batch << " x " << size << "x" << size << (same_a ? " (same A)" : "") << ": " << t.lapAvg() << "+-" << t.lapStd() << " s, "
+              << 2.0 * batch * size * size * size / t.lapAvg() / 1e9 << " GFlops, "
+              << batch / t.lapAvg() / 1e6 << " millions of products/s" << std::endl;
+
+    std::vector<float> c((size_t) batch * matrix);
+    c_gpu.readN(c.data(), c.size());
+
+    // Эталон считается на процессоре через OpenMP
+    std::vector<double> expected((size_t) batch * matrix);
+    #pragma omp parallel for
+    for (int i = 0; i < (int) batch; ++i) {
+        const float *ma = a.data() + (size_t) i * stride_a;
+        const float *mb = b.data() + (size_t) i * matrix;
+        double *mc = expected.data() + (size_t) i * matrix;
+        for (unsigned int row = 0; row < size; ++row) {
+            for (unsigned int col = 0; col < size; ++col) {
+                double sum = 0.0;
+                for (unsigned int l = 0; l < size; ++l) {
+                    sum += (double) ma[row * size + l] * mb[l * size + col];
+                }
+                mc[row * size + col] = sum;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < c.size(); ++i) {
+        EXPECT_THE_SAME(true, std::abs(c[i] - expected[i]) <= 1e-5 * size, "GPU batched GEMM should be the same as CPU!");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 16*1024*1024;
+    int iters = 10;
+
+    unsigned int sizes[] = {3, 4, 8, 16, 32, 64};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        benchmark(sizes[i], n, false, iters);
+    }
+    benchmark(4, n, true, iters);
+
+    return 0;
+}
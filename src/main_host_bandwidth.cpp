@@ -0,0 +1,60 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_host_buffer.h>
+#include <libgpu/shared_device_buffer.h>
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+
+// Замеряет пропускную способность передачи данных между хостом и видеокартой
+// из обычной (pageable) памяти и из закрепленной (pinned) памяти shared_host_buffer
+void benchmark(const std::string &name, gpu::gpu_host_mem_any &host, gpu::gpu_mem_any &device, int iters)
+{
+    size_t size = host.size();
+    memset(host.get(), 239, size);
+
+    timer t;
+    for (int iter = 0; iter < iters; ++iter) {
+        device.write(host, size);
+        t.nextLap();
+    }
+    double h2d = size / t.lapAvg() / (1024 * 1024 * 1024);
+
+    t.restart();
+    for (int iter = 0; iter < iters; ++iter) {
+        device.read(host, size);
+        t.nextLap();
+    }
+    double d2h = size / t.lapAvg() / (1024 * 1024 * 1024);
+
+    std::cout << name << (host.isPinned() ? " (pinned)" : " (paged)") << ": "
+              << "H2D " << h2d << " GB/s, D2H " << d2h << " GB/s" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    size_t size = 256 * 1024 * 1024;
+    int iters = 10;
+
+    gpu::gpu_mem_any device_buffer;
+    device_buffer.resize(size);
+
+    // Обычная память выделяется через malloc, драйвер копирует ее через промежуточный pinned буфер
+    gpu::gpu_host_mem_any paged = gpu::gpu_host_mem_any::createPaged(size);
+    benchmark("malloc", paged, device_buffer, iters);
+
+    // Закрепленная память - это отображенный CL_MEM_ALLOC_HOST_PTR буфер, копируется через DMA напрямую
+    gpu::gpu_host_mem_any pinned = gpu::gpu_host_mem_any::create(size);
+    benchmark("CL_MEM_ALLOC_HOST_PTR", pinned, device_buffer, iters);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+
+// Этот файл будет сгенерирован автоматически в момент сборки - см. convertIntoHeader в CMakeLists.txt
+#include "cl/launch_overhead_cl.h"
+
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+// Столько аргументов со значениями по умолчанию принимали exec и setArgs до перехода на вариативные шаблоны
+const size_t legacy_nargs = 41;
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 256;
+    int launches = 10*1000;
+    int iters = 10;
+
+    gpu::gpu_mem_32u as_gpu;
+    as_gpu.resizeN(n);
+    std::vector<unsigned int> as(n, 0);
+    as_gpu.writeN(as.data(), n);
+
+    // KernelSource напрямую, а не ocl::Kernel, потому что нужен и вызов с массивом аргументов execAsyncArray
+    std::shared_ptr<ocl::ProgramBinaries> program = std::make_shared<ocl::ProgramBinaries>(launch_overhead_kernel, launch_overhead_kernel_length);
+    ocl::KernelSource increment(program, "increment");
+    increment.precompile();
+
+    gpu::WorkSize ws(n, n);
+
+    // Первый запуск создает кернел на устройстве, поэтому не замеряется
+    increment.exec(ws, as_gpu, n);
+    unsigned int total = 1;
+
+    // Замеряется постановка launches запусков в очередь и ожидание их завершения,
+    // кернел почти пустой, поэтому время определяется накладными расходами на запуск
+    {
+        timer t;
+        for (int iter = 0; iter < iters; ++iter) {
+            for (int launch = 0; launch < launches; ++launch) {
+                increment.execAsync(ws, as_gpu, n);
+            }
+            context.finish();
+            t.nextLap();
+        }
+        total += iters * launches;
+        std::cout << "Variadic exec (2 args): " << t.lapAvg() / launches * 1e6 << " us per launch" << std::endl;
+    }
+
+    // Прежний путь: на каждый запуск собирается массив из 41 аргумента, из которых заданы только первые,
+    // а остальные пустые и пропускаются в setArgArray
+    {
+        timer t;
+        for (int iter = 0; iter < iters; ++iter) {
+            for (int launch = 0; launch < launches; ++launch) {
+                ocl::KernelSource::Arg args[legacy_nargs];
+                args[0] = ocl::KernelSource::Arg(as_gpu);
+                args[1] = ocl::KernelSource::Arg(n);
+                increment.execAsyncArray(ocl::OpenCLStream(), ws, args, legacy_nargs);
+            }
+            context.finish();
+            t.nextLap();
+        }
+        total += iters * launches;
+        std::cout << "setArgArray (" << legacy_nargs << " args): " << t.lapAvg() / launches * 1e6 << " us per launch" << std::endl;
+    }
+
+    // Каждый запуск увеличивает все элементы на единицу
+    as_gpu.readN(as.data(), n);
+    for (unsigned int i = 0; i < n; ++i) {
+        EXPECT_THE_SAME(total, as[i], "Every launch should increment every element!");
+    }
+
+    return 0;
+}
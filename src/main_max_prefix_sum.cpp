@@ -0,0 +1,183 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/primitives/max_prefix_sum.h>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+// Эталон на процессоре: при равных префиксных суммах побеждает первый индекс (строгое сравнение)
+gpu::MaxPrefixSum<int> cpuMaxPrefixSum(const std::vector<int> &as)
+{
+    gpu::MaxPrefixSum<int> res;
+    for (size_t i = 0; i < as.size(); ++i) {
+        res.sum += as[i];
+        if (i == 0 || res.sum > res.max_prefix) {
+            res.max_prefix = res.sum;
+            res.index = i;
+        }
+    }
+    res.count = as.size();
+    return res;
+}
+
+void expectTheSame(const gpu::MaxPrefixSum<int> &expected, const gpu::MaxPrefixSum<int> &res, const std::string &name)
+{
+    EXPECT_THE_SAME(expected.count, res.count, name + ": count should be the same as CPU!");
+    EXPECT_THE_SAME(expected.sum, res.sum, name + ": sum should be the same as CPU!");
+    EXPECT_THE_SAME(expected.max_prefix, res.max_prefix, name + ": max prefix should be the same as CPU!");
+    EXPECT_THE_SAME(expected.index, res.index, name + ": index should be the same as CPU!");
+}
+
+void checkDevice(const std::vector<int> &as, const std::string &name)
+{
+    unsigned int n = (unsigned int) as.size();
+    gpu::gpu_mem_32i as_gpu;
+    as_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+
+    expectTheSame(cpuMaxPrefixSum(as), gpu::maxPrefixSum(as_gpu, n), name);
+}
+
+// Ряд подается потоку кусками неравного размера: отдельными буферами на видеокарте и массивом с хоста,
+// который поток сам делит на части по max_part элементов
+void checkStream(const std::vector<int> &as, const std::vector<unsigned int> &chunks, size_t max_part, const std::string &name)
+{
+    gpu::MaxPrefixSum<int> expected = cpuMaxPrefixSum(as);
+
+    gpu::MaxPrefixSumStream<int> device_stream;
+    size_t offset = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        gpu::gpu_mem_32i chunk_gpu;
+        chunk_gpu.resizeN(chunks[i]);
+        chunk_gpu.writeN(as.data() + offset, chunks[i]);
+        device_stream.append(chunk_gpu, chunks[i]);
+        offset += chunks[i];
+    }
+    EXPECT_THE_SAME(as.size(), offset, name + ": chunks should cover the whole series!");
+    expectTheSame(expected, device_stream.result(), name + " (device chunks)");
+
+    gpu::MaxPrefixSumStream<int> host_stream(max_part);
+    offset = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        host_stream.append(as.data() + offset, chunks[i]);
+        offset += chunks[i];
+    }
+    expectTheSame(expected, host_stream.result(), name + " (host chunks split by " + to_string(max_part) + ")");
+
+    host_stream.reset();
+    host_stream.append(as.data(), as.size());
+    expectTheSame(expected, host_stream.result(), name + " (whole host array split by " + to_string(max_part) + ")");
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    // Размер не кратен тайлу (до 1024 элементов на группу), чтобы последняя группа была неполной
+    unsigned int n = 10*1000*1000 + 123;
+    int iters = 10;
+
+    std::vector<int> as(n);
+    FastRandom r(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        as[i] = r.next(-100, 100);
+    }
+    std::cout << "Data generated for n=" << n << "!" << std::endl;
+
+    gpu::MaxPrefixSum<int> expected;
+    {
+        timer t;
+        expected = cpuMaxPrefixSum(as);
+        std::cout << "CPU: " << t.elapsed() << " s, " << n * sizeof(int) / t.elapsed() / (1024 * 1024 * 1024) << " GB/s" << std::endl;
+    }
+
+    gpu::gpu_mem_32i as_gpu;
+    as_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+
+    {
+        // Первый запуск компилирует кернелы, поэтому не замеряется
+        gpu::MaxPrefixSum<int> res = gpu::maxPrefixSum(as_gpu, n);
+        expectTheSame(expected, res, "Random");
+
+        timer t;
+        for (int iter = 0; iter < iters; ++iter) {
+            res = gpu::maxPrefixSum(as_gpu, n);
+            t.nextLap();
+        }
+        std::cout << "GPU: " << t.lapAvg() << "+-" << t.lapStd() << " s, "
+                  << n * sizeof(int) / t.lapAvg() / (1024 * 1024 * 1024) << " GB/s" << std::endl;
+    }
+
+    // Маленькие размеры вокруг границы тайла
+    unsigned int small_ns[] = {1, 2, 255, 1023, 1024, 1025, 4097};
+    for (unsigned int ni : small_ns) {
+        std::vector<int> small(as.begin(), as.begin() + ni);
+        checkDevice(small, "Random n=" + to_string(ni));
+    }
+
+    // Равные максимумы: при чередовании 1, -1 максимум 1 достигается на каждом четном индексе, из нуля - везде,
+    // а сдвиг на тайл проверяет, что при слиянии групп первый индекс тоже побеждает
+    {
+        std::vector<int> alternating(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            alternating[i] = (i % 2 == 0) ? 1 : -1;
+        }
+        checkDevice(alternating, "Alternating ties");
+
+        std::vector<int> zeros(n, 0);
+        checkDevice(zeros, "Zero ties");
+
+        std::vector<int> shifted(n, 0);
+        shifted[1500] = 7;
+        shifted[2000] = -7;
+        shifted[5000] = 7;
+        checkDevice(shifted, "Ties across tiles");
+    }
+
+    // Все элементы отрицательны: максимум - первый элемент
+    {
+        std::vector<int> negative(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            negative[i] = r.next(-100, -1);
+        }
+        checkDevice(negative, "All negative");
+    }
+
+    // Поток: границы кусков не совпадают с тайлами, а max_part меньше кусков, чтобы сработало деление массива с хоста
+    {
+        std::vector<unsigned int> chunks = {1, 1000, 3333, 1024, 17, n - 1 - 1000 - 3333 - 1024 - 17};
+        checkStream(as, chunks, 1000*1000 + 7, "Stream random");
+
+        std::vector<int> negative(100*1000 + 11);
+        for (size_t i = 0; i < negative.size(); ++i) {
+            negative[i] = r.next(-100, -1);
+        }
+        std::vector<unsigned int> negative_chunks = {5000, 1, 50*1000, (unsigned int) negative.size() - 5000 - 1 - 50*1000};
+        checkStream(negative, negative_chunks, 777, "Stream all negative");
+    }
+
+    return 0;
+}
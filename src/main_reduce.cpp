@@ -0,0 +1,107 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/primitives/reduce.h>
+
+#include <vector>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 100*1000*1000;
+    int iters = 10;
+
+    std::vector<unsigned int> as(n);
+    std::vector<float> fs(n);
+    FastRandom r(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        as[i] = (unsigned int) r.next(0, 1000);
+        fs[i] = r.nextf();
+    }
+    std::cout << "Data generated for n=" << n << "!" << std::endl;
+
+    // Эталон считается на всех ядрах процессора через OpenMP (сумма unsigned int переполняется так же, как на видеокарте)
+    unsigned int cpu_sum = 0;
+    double cpu_fsum = 0.0;
+    {
+        timer t;
+        for (int iter = 0; iter < iters; ++iter) {
+            unsigned int sum = 0;
+            #pragma omp parallel for reduction(+:sum)
+            for (int i = 0; i < (int) n; ++i) {
+                sum += as[i];
+            }
+            cpu_sum = sum;
+            t.nextLap();
+        }
+        std::cout << "CPU OpenMP sum: " << t.lapAvg() << "+-" << t.lapStd() << " s, "
+                  << n * sizeof(unsigned int) / t.lapAvg() / (1024 * 1024 * 1024) << " GB/s" << std::endl;
+
+        #pragma omp parallel for reduction(+:cpu_fsum)
+        for (int i = 0; i < (int) n; ++i) {
+            cpu_fsum += fs[i];
+        }
+    }
+
+    unsigned int cpu_min = as[0], cpu_max = as[0];
+    for (unsigned int i = 1; i < n; ++i) {
+        cpu_min = std::min(cpu_min, as[i]);
+        cpu_max = std::max(cpu_max, as[i]);
+    }
+
+    gpu::gpu_mem_32u as_gpu;
+    gpu::gpu_mem_32f fs_gpu;
+    as_gpu.resizeN(n);
+    fs_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+    fs_gpu.writeN(fs.data(), n);
+
+    {
+        // Первый запуск компилирует кернел, поэтому не замеряется
+        unsigned int sum = gpu::reduce(as_gpu, n);
+
+        timer t;
+        for (int iter = 0; iter < iters; ++iter) {
+            sum = gpu::reduce(as_gpu, n);
+            t.nextLap();
+        }
+        std::cout << "GPU sum: " << t.lapAvg() << "+-" << t.lapStd() << " s, "
+                  << n * sizeof(unsigned int) / t.lapAvg() / (1024 * 1024 * 1024) << " GB/s" << std::endl;
+        EXPECT_THE_SAME(cpu_sum, sum, "GPU sum should be the same as CPU sum!");
+    }
+
+    EXPECT_THE_SAME(cpu_min, gpu::reduce(as_gpu, n, gpu::ReduceMin), "GPU min should be the same as CPU min!");
+    EXPECT_THE_SAME(cpu_max, gpu::reduce(as_gpu, n, gpu::ReduceMax), "GPU max should be the same as CPU max!");
+
+    // Сумма float зависит от порядка сложения, поэтому сравнивается с точностью до относительной погрешности
+    float fsum = gpu::reduce(fs_gpu, n);
+    std::cout << "GPU float sum: " << fsum << ", CPU double sum: " << cpu_fsum << std::endl;
+    if (std::abs(fsum - cpu_fsum) > 1e-3 * std::max(std::abs(cpu_fsum), 1e3)) {
+        throw std::runtime_error("GPU float sum is too far from CPU sum!");
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/primitives/scan.h>
+
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 100*1000*1000;
+    int iters = 10;
+
+    std::vector<unsigned int> as(n);
+    FastRandom r(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        as[i] = (unsigned int) r.next(0, 1000);
+    }
+    std::cout << "Data generated for n=" << n << "!" << std::endl;
+
+    // Эталонные префиксные суммы считаются на процессоре последовательно
+    std::vector<unsigned int> inclusive(n), exclusive(n);
+    {
+        timer t;
+        unsigned int sum = 0;
+        for (unsigned int i = 0; i < n; ++i) {
+            exclusive[i] = sum;
+            sum += as[i];
+            inclusive[i] = sum;
+        }
+        std::cout << "CPU: " << t.elapsed() << " s, " << 2.0 * n * sizeof(unsigned int) / t.elapsed() / (1024 * 1024 * 1024) << " GB/s" << std::endl;
+    }
+
+    gpu::gpu_mem_32u as_gpu, res_gpu;
+    as_gpu.resizeN(n);
+    res_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+
+    // Пропускная способность считается по объему прочитанных и записанных данных: n чисел на входе и n на выходе
+    {
+        // Первый запуск компилирует кернелы, поэтому не замеряется
+        gpu::scan(as_gpu, res_gpu, n);
+
+        timer t;
+        for (int iter = 0; iter < iters; ++iter) {
+            gpu::scan(as_gpu, res_gpu, n);
+            t.nextLap();
+        }
+        std::cout << "GPU inclusive: " << t.lapAvg() << "+-" << t.lapStd() << " s, "
+                  << 2.0 * n * sizeof(unsigned int) / t.lapAvg() / (1024 * 1024 * 1024) << " GB/s" << std::endl;
+    }
+
+    std::vector<unsigned int> res(n);
+    res_gpu.readN(res.data(), n);
+    for (unsigned int i = 0; i < n; ++i) {
+        EXPECT_THE_SAME(inclusive[i], res[i], "GPU inclusive scan should be the same as CPU!");
+    }
+
+    // Исключающий вариант на месте: результат записывается во входной буфер
+    gpu::scan(as_gpu, as_gpu, n, gpu::ScanExclusive);
+    as_gpu.readN(res.data(), n);
+    for (unsigned int i = 0; i < n; ++i) {
+        EXPECT_THE_SAME(exclusive[i], res[i], "GPU exclusive in-place scan should be the same as CPU!");
+    }
+
+    return 0;
+}
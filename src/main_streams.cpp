@@ -0,0 +1,144 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_host_buffer.h>
+#include <libgpu/shared_device_buffer.h>
+
+// Этот файл будет сгенерирован автоматически в момент сборки - см. convertIntoHeader в CMakeLists.txt
+#include "cl/streams_cl.h"
+
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+const unsigned int work_group_size = 256;
+const unsigned int steps = 32;
+
+// Данные обрабатываются кусками: загрузка куска, кернел над ним и выгрузка результата.
+// Куски раздаются потокам (очередям) по кругу, у каждого потока свои буферы на видеокарте,
+// поэтому пока один поток копирует, другой может считать. Внутри потока команды выполняются по порядку.
+// Возвращает события выгрузки последнего куска каждого потока
+std::vector<ocl::OpenCLEvent> process(ocl::Kernel &kernel, const std::vector<ocl::OpenCLStream> &streams,
+                                      std::vector<gpu::gpu_mem_32u> &as_gpu, std::vector<gpu::gpu_mem_32u> &bs_gpu,
+                                      const gpu::gpu_host_mem_32u &as, gpu::gpu_host_mem_32u &bs, unsigned int n, unsigned int chunk)
+{
+    std::vector<ocl::OpenCLEvent> last(streams.size());
+    for (unsigned int offset = 0, i = 0; offset < n; offset += chunk, ++i) {
+        const ocl::OpenCLStream &stream = streams[i % streams.size()];
+        gpu::gpu_mem_32u &a_gpu = as_gpu[i % streams.size()];
+        gpu::gpu_mem_32u &b_gpu = bs_gpu[i % streams.size()];
+        unsigned int part = std::min(chunk, n - offset);
+
+        ocl::OpenCLEvent uploaded = a_gpu.writeNAsync(as.get() + offset, part, stream);
+        ocl::OpenCLEvent computed = kernel.execAsync(stream.after(uploaded), gpu::WorkSize(work_group_size, part),
+                                                     a_gpu, b_gpu, part, steps);
+        last[i % streams.size()] = b_gpu.readNAsync(bs.get() + offset, part, 0, stream.after(computed));
+
+        // Сбрасываем очередь, чтобы драйвер начал исполнять команды, не дожидаясь конца постановки остальных кусков
+        gpu::Context().cl()->flush(stream);
+    }
+    return last;
+}
+
+double benchmark(const std::string &name, ocl::Kernel &kernel, const std::vector<ocl::OpenCLStream> &streams,
+                 const gpu::gpu_host_mem_32u &as, gpu::gpu_host_mem_32u &bs, unsigned int n, unsigned int chunk, int iters)
+{
+    std::vector<gpu::gpu_mem_32u> as_gpu(streams.size()), bs_gpu(streams.size());
+    for (size_t i = 0; i < streams.size(); ++i) {
+        as_gpu[i].resizeN(chunk);
+        bs_gpu[i].resizeN(chunk);
+    }
+
+    timer t;
+    for (int iter = 0; iter < iters; ++iter) {
+        std::vector<ocl::OpenCLEvent> last = process(kernel, streams, as_gpu, bs_gpu, as, bs, n, chunk);
+        for (size_t i = 0; i < last.size(); ++i) {
+            last[i].wait();
+        }
+        t.nextLap();
+    }
+    // Учитываются и загрузка, и выгрузка: n чисел в каждую сторону
+    std::cout << name << ": " << t.lapAvg() << "+-" << t.lapStd() << " s, "
+              << 2.0 * n * sizeof(unsigned int) / t.lapAvg() / (1024 * 1024 * 1024) << " GB/s" << std::endl;
+    return t.lapAvg();
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 64*1024*1024;
+    unsigned int chunk = 4*1024*1024;
+    int iters = 10;
+
+    // Копирование идет асинхронно только из закрепленной (pinned) памяти, поэтому данные хоста лежат в ней
+    gpu::gpu_host_mem_32u as = gpu::gpu_host_mem_32u::createN(n);
+    gpu::gpu_host_mem_32u bs = gpu::gpu_host_mem_32u::createN(n);
+    FastRandom r(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        as.get()[i] = (unsigned int) r.next();
+    }
+    std::cout << "Data generated for n=" << n << (as.isPinned() ? " in pinned memory" : " in paged memory") << "!" << std::endl;
+
+    std::vector<unsigned int> expected(n);
+    #pragma omp parallel for
+    for (int i = 0; i < (int) n; ++i) {
+        unsigned int x = as.get()[i];
+        for (unsigned int step = 0; step < steps; ++step) {
+            x = x * 1664525u + 1013904223u;
+        }
+        expected[i] = x;
+    }
+
+    ocl::Kernel lcg(streams_kernel, streams_kernel_length, "lcg");
+    lcg.compile();
+
+    // Первый прогон компилирует кернел и выделяет память, поэтому не замеряется
+    std::vector<ocl::OpenCLStream> default_queue(1);
+    {
+        std::vector<gpu::gpu_mem_32u> as_gpu(1), bs_gpu(1);
+        as_gpu[0].resizeN(chunk);
+        bs_gpu[0].resizeN(chunk);
+        process(lcg, default_queue, as_gpu, bs_gpu, as, bs, n, chunk)[0].wait();
+    }
+
+    // На одной очереди загрузка, вычисления и выгрузка идут строго друг за другом
+    double sequential = benchmark("Default queue", lcg, default_queue, as, bs, n, chunk, iters);
+    for (unsigned int i = 0; i < n; ++i) {
+        EXPECT_THE_SAME(expected[i], bs.get()[i], "GPU results on the default queue should be equal to CPU results!");
+    }
+
+    memset(bs.get(), 0, n * sizeof(unsigned int));
+
+    // На двух потоках загрузка одного куска перекрывается с вычислениями и выгрузкой другого
+    std::vector<ocl::OpenCLStream> two_streams;
+    two_streams.push_back(context.stream("streams0"));
+    two_streams.push_back(context.stream("streams1"));
+    double overlapped = benchmark("Two streams", lcg, two_streams, as, bs, n, chunk, iters);
+    for (unsigned int i = 0; i < n; ++i) {
+        EXPECT_THE_SAME(expected[i], bs.get()[i], "GPU results on two streams should be equal to CPU results!");
+    }
+
+    std::cout << "Speedup: " << sequential / overlapped << "x" << std::endl;
+
+    return 0;
+}
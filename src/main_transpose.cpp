@@ -0,0 +1,114 @@
+#include <libutils/misc.h>
+#include <libutils/timer.h>
+#include <libutils/fast_random.h>
+#include <libgpu/context.h>
+#include <libgpu/shared_device_buffer.h>
+#include <libgpu/primitives/transpose.h>
+
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+
+template<typename T>
+void raiseFail(const T &a, const T &b, std::string message, std::string filename, int line)
+{
+    if (a != b) {
+        std::cerr << message << " But " << a << " != " << b << ", " << filename << ":" << line << std::endl;
+        throw std::runtime_error(message);
+    }
+}
+
+#define EXPECT_THE_SAME(a, b, message) raiseFail(a, b, message, __FILE__, __LINE__)
+
+
+// Возвращает достигнутую пропускную способность транспонирования в GB/s
+double benchmark(unsigned int width, unsigned int height, unsigned int batch, int iters)
+{
+    size_t n = (size_t) width * height * batch;
+
+    std::vector<float> as(n);
+    FastRandom r(width + height + batch);
+    for (size_t i = 0; i < n; ++i) {
+        as[i] = r.nextf();
+    }
+
+    gpu::gpu_mem_32f as_gpu, res_gpu;
+    as_gpu.resizeN(n);
+    res_gpu.resizeN(n);
+    as_gpu.writeN(as.data(), n);
+
+    // Первый запуск компилирует кернел, поэтому не замеряется
+    gpu::transpose(as_gpu, res_gpu, width, height, batch);
+
+    // Пропускная способность считается по объему прочитанных и записанных данных: n чисел на входе и n на выходе
+    timer t;
+    for (int iter = 0; iter < iters; ++iter) {
+        gpu::transpose(as_gpu, res_gpu, width, height, batch);
+        t.nextLap();
+    }
+    double bandwidth = 2.0 * n * sizeof(float) / t.lapAvg() / (1024 * 1024 * 1024);
+    std::cout << "GPU transpose " << height << "x" << width << " x" << batch << ": " << t.lapAvg() << "+-" << t.lapStd() << " s, "
+              << bandwidth << " GB/s" << std::endl;
+
+    // Элемент (y, x) матрицы k должен оказаться на месте (x, y)
+    std::vector<float> res(n);
+    res_gpu.readN(res.data(), n);
+    for (unsigned int k = 0; k < batch; ++k) {
+        size_t offset = (size_t) k * width * height;
+        for (unsigned int y = 0; y < height; ++y) {
+            for (unsigned int x = 0; x < width; ++x) {
+                EXPECT_THE_SAME(as[offset + (size_t) y * width + x], res[offset + (size_t) x * height + y], "GPU transpose should be the same as CPU!");
+            }
+        }
+    }
+
+    return bandwidth;
+}
+
+int main(int argc, char **argv)
+{
+    gpu::Device device = gpu::chooseGPUDevice(argc, argv);
+
+    gpu::Context context;
+    context.init(device.device_id_opencl);
+    context.activate();
+
+    unsigned int n = 64*1024*1024;
+    int iters = 10;
+
+    // Простое копирование буфера - верхняя граница того, что можно ожидать от транспонирования
+    double copy_bandwidth;
+    {
+        gpu::gpu_mem_32f as_gpu, res_gpu;
+        as_gpu.resizeN(n);
+        res_gpu.resizeN(n);
+
+        as_gpu.copyToN(res_gpu, n);
+        context.finish();
+
+        timer t;
+        for (int iter = 0; iter < iters; ++iter) {
+            as_gpu.copyToN(res_gpu, n);
+            context.finish();
+            t.nextLap();
+        }
+        copy_bandwidth = 2.0 * n * sizeof(float) / t.lapAvg() / (1024 * 1024 * 1024);
+        std::cout << "GPU copy: " << t.lapAvg() << "+-" << t.lapStd() << " s, " << copy_bandwidth << " GB/s" << std::endl;
+    }
+
+    // Квадратная, неквадратные (размеры не кратны тайлу) и пачка маленьких матриц - всего по n элементов
+    unsigned int sizes[][3] = {
+        {8192, 8192, 1},
+        {16384 + 3, 4096 - 5, 1},
+        {1000, 67000, 1},
+        {256, 256, 1024},
+    };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        double bandwidth = benchmark(sizes[i][0], sizes[i][1], sizes[i][2], iters);
+        std::cout << "    " << 100.0 * bandwidth / copy_bandwidth << "% of copy bandwidth" << std::endl;
+    }
+
+    return 0;
+}